@@ -0,0 +1,202 @@
+// myutils-logbench: call-site latency and sustained throughput of Debug::Logger
+//   myutils-logbench [--threads N] [--messages M] [--policy block|drop-newest|drop-oldest|spill]
+//                    [--sinks null,file,console] [--sizes small,medium,large] [--rate-limit]
+// Every combination of sink, message size and producer count (1, 2, 4 .. N) logs M messages per
+// thread. Latency is the time spent in the log call, sustained throughput counts until flush()
+// returns, so a logger thread that cannot keep up shows as the gap between the two rates and as
+// drops. The report goes to stderr, run with > /dev/null when the console sink is included.
+#include "Debug.h"
+#include "TscClock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Options
+    {
+        unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        size_t messages = 100'000;     // per thread
+        Debug::Logger::Backpressure policy = Debug::Logger::Backpressure::DropNewest;
+        std::vector<std::string> sinks{ "null", "file", "console" };
+        std::vector<std::string> sizes{ "small", "medium", "large" };
+        bool rateLimit = false;
+    };
+
+    struct Result
+    {
+        std::vector<uint32_t> latencies;    // TscClock ticks per call, every thread
+        double callSeconds = 0;             // until the last producer returned
+        double totalSeconds = 0;            // until flush returned
+        uint64_t dropped = 0;
+        uint64_t suppressed = 0;
+        uint64_t sinkDroppedBytes = 0;
+    };
+
+    std::vector<std::string> split(std::string_view list)
+    {
+        std::vector<std::string> parts;
+        while (!list.empty()) {
+            const size_t comma = list.find(',');
+            parts.emplace_back(list.substr(0, comma));
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        }
+        return parts;
+    }
+
+    bool parsePolicy(std::string_view name, Debug::Logger::Backpressure& policy)
+    {
+        using Backpressure = Debug::Logger::Backpressure;
+        if (name == "block") policy = Backpressure::Block;
+        else if (name == "drop-newest") policy = Backpressure::DropNewest;
+        else if (name == "drop-oldest") policy = Backpressure::DropOldest;
+        else if (name == "spill") policy = Backpressure::Spill;
+        else return false;
+        return true;
+    }
+
+    // The console sink is async like the logger's default one, the file sink writes on the logger thread
+    std::shared_ptr<Debug::LogSink> makeSink(std::string_view name)
+    {
+        if (name == "null") return std::make_shared<Debug::NullLogSink>();
+        if (name == "file") return std::make_shared<Debug::FileLogSink>("logbench.txt", false);
+        if (name == "console") return std::make_shared<Debug::AsyncLogSink>(std::make_shared<Debug::ConsoleLogSink>());
+        return nullptr;
+    }
+
+    // small: one integer, medium: a 64 byte string, large: a 1 KB string that does not fit a
+    // record and takes the eager formatting path
+    void logOne(std::string_view size, size_t i, std::string_view text)
+    {
+        if (size == "small") Debug::Info("bench {}", i);
+        else Debug::Info("bench {} {}", i, text);
+    }
+
+    Result run(const Options& options, std::string_view size, unsigned threads)
+    {
+        Debug::Logger& logger = Debug::Logger::Instance();
+        const std::string text(size == "large" ? 1024 : 64, 'x');
+        Result result;
+        result.latencies.resize(options.messages * threads);
+        const uint64_t droppedBefore = logger.droppedCount();
+        const uint64_t suppressedBefore = logger.suppressedCount();
+
+        std::atomic_uint ready = 0;
+        std::atomic_bool go = false;
+        std::vector<std::thread> producers;
+        for (unsigned t = 0; t < threads; ++t) {
+            producers.emplace_back([&, t] {
+                uint32_t* latencies = result.latencies.data() + t * options.messages;
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                for (size_t i = 0; i < options.messages; ++i) {
+                    const uint64_t start = utl::TscClock::ticks();
+                    logOne(size, i, text);
+                    latencies[i] = static_cast<uint32_t>(std::min<uint64_t>(utl::TscClock::ticks() - start, UINT32_MAX));
+                }
+                });
+        }
+        while (ready.load() != threads) std::this_thread::yield();
+
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& producer : producers) producer.join();
+        const auto called = std::chrono::steady_clock::now();
+        logger.flush();
+        const auto flushed = std::chrono::steady_clock::now();
+
+        result.callSeconds = std::chrono::duration<double>(called - start).count();
+        result.totalSeconds = std::chrono::duration<double>(flushed - start).count();
+        result.dropped = logger.droppedCount() - droppedBefore;
+        result.suppressed = logger.suppressedCount() - suppressedBefore;
+        return result;
+    }
+
+    void report(std::string_view sink, std::string_view size, unsigned threads, size_t messages, Result& result, double nanosPerTick)
+    {
+        auto percentile = [&](double p) {
+            const size_t index = std::min(result.latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(result.latencies.size())));
+            std::nth_element(result.latencies.begin(), result.latencies.begin() + index, result.latencies.end());
+            return static_cast<double>(result.latencies[index]) * nanosPerTick;
+        };
+        const double total = static_cast<double>(messages) * threads;
+        const double p50 = percentile(0.50), p90 = percentile(0.90), p99 = percentile(0.99), p999 = percentile(0.999);
+        const double max = static_cast<double>(*std::max_element(result.latencies.begin(), result.latencies.end())) * nanosPerTick;
+        std::fputs(std::format("{:<8} {:<7} {:>3} | {:>8.0f} {:>8.0f} {:>8.0f} {:>9.0f} {:>10.0f} | {:>11.0f} {:>11.0f} | {:>9} {:>9} {:>9}\n",
+            sink, size, threads, p50, p90, p99, p999, max, total / result.callSeconds, total / result.totalSeconds,
+            result.dropped, result.suppressed, result.sinkDroppedBytes).c_str(), stderr);
+    }
+
+    int usage(const char* program)
+    {
+        std::fputs(std::format("usage: {} [--threads N] [--messages M] [--policy block|drop-newest|drop-oldest|spill] "
+            "[--sinks null,file,console] [--sizes small,medium,large] [--rate-limit]\n", program).c_str(), stderr);
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) options.maxThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--messages" && hasValue) options.messages = std::max(1ll, std::atoll(argv[++i]));
+        else if (arg == "--policy" && hasValue) {
+            if (!parsePolicy(argv[++i], options.policy)) return usage(argv[0]);
+        }
+        else if (arg == "--sinks" && hasValue) options.sinks = split(argv[++i]);
+        else if (arg == "--sizes" && hasValue) options.sizes = split(argv[++i]);
+        else if (arg == "--rate-limit") options.rateLimit = true;
+        else return usage(argv[0]);
+    }
+    for (const auto& size : options.sizes) {
+        if (size != "small" && size != "medium" && size != "large") return usage(argv[0]);
+    }
+
+    Debug::Init();
+    Debug::Logger& logger = Debug::Logger::Instance();
+    logger.setBackpressure(options.policy);
+    if (options.rateLimit) logger.setRateLimit({ 256, 64 });
+    const double nanosPerTick = 1e9 / utl::TscCalibration().ticksPerSecond();
+
+    std::fputs(std::format("{:<8} {:<7} {:>3} | {:>8} {:>8} {:>8} {:>9} {:>10} | {:>11} {:>11} | {:>9} {:>9} {:>9}\n",
+        "sink", "size", "thr", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns", "calls/s", "written/s",
+        "dropped", "limited", "sink drop").c_str(), stderr);
+    for (const auto& sinkName : options.sinks) {
+        std::shared_ptr<Debug::LogSink> sink;
+        try {
+            sink = makeSink(sinkName);
+        }
+        catch (const std::exception& e) {
+            std::fputs(std::format("{}: {}\n", sinkName, e.what()).c_str(), stderr);
+            continue;
+        }
+        if (!sink) return usage(argv[0]);
+        logger.clearSinks();
+        logger.addSink(sink);
+        for (const auto& size : options.sizes) {
+            for (unsigned threads = 1;; threads = std::min(threads * 2, options.maxThreads)) {
+                const auto* async = dynamic_cast<const Debug::AsyncLogSink*>(sink.get());
+                const uint64_t sinkDropsBefore = async ? async->droppedBytes() : 0;
+                Result result = run(options, size, threads);
+                result.sinkDroppedBytes = async ? async->droppedBytes() - sinkDropsBefore : 0;
+                report(sinkName, size, threads, options.messages, result, nanosPerTick);
+                if (threads == options.maxThreads) break;
+            }
+        }
+        logger.clearSinks();
+    }
+    std::error_code ignored;
+    std::filesystem::remove("logbench.txt", ignored);
+    return 0;
+}
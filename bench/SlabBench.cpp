@@ -0,0 +1,164 @@
+// myutils-slabbench: allocate/free cost of the slab allocator against new/delete and the std::pmr pools
+//   myutils-slabbench [--threads N] [--ops M] [--live L] [--repeat R]
+// Each thread keeps L blocks alive and replaces a random one M times, for every size class
+// boundary from 1 to 1024 bytes and for sizes mixed uniformly over 1..1024. unsynchronized is one
+// std::pmr::unsynchronized_pool_resource per thread, synchronized one shared pool for all of them.
+// Every cell is the best of R runs, which keeps a noisy machine from deciding the comparison.
+#include "SlabAllocator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Options
+    {
+        unsigned threads = 1;
+        size_t ops = 2'000'000;     // per thread
+        size_t live = 4096;         // per thread
+        unsigned repeat = 3;
+    };
+
+    // One contender, allocate and deallocate take the size like SlabAllocator does
+    struct Allocator
+    {
+        std::string_view name;
+        void* (*allocate)(void* state, size_t bytes);
+        void (*deallocate)(void* state, void* ptr, size_t bytes);
+        // Per-thread state, e.g. the thread's own pool. Returns nullptr when nothing is needed
+        std::unique_ptr<std::pmr::memory_resource> (*makeState)(std::pmr::memory_resource* shared);
+    };
+
+    std::unique_ptr<std::pmr::memory_resource> noState(std::pmr::memory_resource*) { return nullptr; }
+
+    void* pmrAllocate(void* state, size_t bytes) { return static_cast<std::pmr::memory_resource*>(state)->allocate(bytes); }
+    void pmrDeallocate(void* state, void* ptr, size_t bytes) { static_cast<std::pmr::memory_resource*>(state)->deallocate(ptr, bytes); }
+
+    const Allocator allocators[] = {
+        { "new/delete",
+            [](void*, size_t bytes) { return ::operator new(bytes); },
+            [](void*, void* ptr, size_t bytes) { ::operator delete(ptr, bytes); },
+            noState },
+        { "SlabResource", pmrAllocate, pmrDeallocate, noState },
+        { "StlSlabAllocator",
+            [](void*, size_t bytes) -> void* { return utl::StlSlabAllocator<std::byte>().allocate(bytes); },
+            [](void*, void* ptr, size_t bytes) { utl::StlSlabAllocator<std::byte>().deallocate(static_cast<std::byte*>(ptr), bytes); },
+            noState },
+        { "unsynchronized", pmrAllocate, pmrDeallocate,
+            [](std::pmr::memory_resource*) -> std::unique_ptr<std::pmr::memory_resource> {
+                return std::make_unique<std::pmr::unsynchronized_pool_resource>();
+            } },
+        { "synchronized", pmrAllocate, pmrDeallocate, noState },
+    };
+
+    struct Workload
+    {
+        std::string name;
+        size_t minSize;
+        size_t maxSize;
+    };
+
+    // xorshift, the same sequence for every allocator
+    struct Random
+    {
+        uint64_t state;
+        uint64_t next() noexcept {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+    };
+
+    void churn(const Allocator& allocator, void* state, const Workload& workload, const Options& options, uint64_t seed)
+    {
+        struct Block
+        {
+            void* ptr;
+            size_t bytes;
+        };
+        Random random{ seed };
+        const size_t span = workload.maxSize - workload.minSize + 1;
+        auto nextSize = [&] { return workload.minSize + random.next() % span; };
+
+        std::vector<Block> blocks(options.live);
+        for (auto& block : blocks) {
+            block.bytes = nextSize();
+            block.ptr = allocator.allocate(state, block.bytes);
+            *static_cast<volatile char*>(block.ptr) = 1;
+        }
+        for (size_t i = 0; i < options.ops; ++i) {
+            Block& block = blocks[random.next() % blocks.size()];
+            allocator.deallocate(state, block.ptr, block.bytes);
+            block.bytes = nextSize();
+            block.ptr = allocator.allocate(state, block.bytes);
+            *static_cast<volatile char*>(block.ptr) = 1;
+        }
+        for (const auto& block : blocks) allocator.deallocate(state, block.ptr, block.bytes);
+    }
+
+    // Nanoseconds per free + allocate pair, wall clock over all threads
+    double run(const Allocator& allocator, const Workload& workload, const Options& options)
+    {
+        std::pmr::synchronized_pool_resource sharedPool;
+        std::pmr::memory_resource* shared = allocator.name == "synchronized" ? &sharedPool : utl::SlabAllocator::resource();
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < options.threads; ++t) {
+            threads.emplace_back([&, t] {
+                const auto own = allocator.makeState(shared);
+                churn(allocator, own ? own.get() : shared, workload, options, 0x9E3779B97F4A7C15ull + t);
+                });
+        }
+        for (auto& thread : threads) thread.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / static_cast<double>(options.ops);
+    }
+
+    int usage(const char* program)
+    {
+        std::fputs(std::format("usage: {} [--threads N] [--ops M] [--live L] [--repeat R]\n", program).c_str(), stderr);
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ops" && hasValue) options.ops = std::max(1ll, std::atoll(argv[++i]));
+        else if (arg == "--live" && hasValue) options.live = std::max(1ll, std::atoll(argv[++i]));
+        else if (arg == "--repeat" && hasValue) options.repeat = std::max(1, std::atoi(argv[++i]));
+        else return usage(argv[0]);
+    }
+
+    std::vector<Workload> workloads;
+    for (size_t size : { 1, 16, 64, 128, 256, 512, 1024 }) workloads.push_back({ std::to_string(size), size, size });
+    workloads.push_back({ "1..1024", 1, utl::SlabAllocator::maxSmallSize });
+
+    std::string header = std::format("{:<8}", "bytes");
+    for (const auto& allocator : allocators) header += std::format(" {:>16}", allocator.name);
+    std::puts(std::format("ns per free + allocate, {} thread(s), {} live blocks each", options.threads, options.live).c_str());
+    std::puts(header.c_str());
+    for (const auto& workload : workloads) {
+        std::string line = std::format("{:<8}", workload.name);
+        for (const auto& allocator : allocators) {
+            double best = run(allocator, workload, options);
+            for (unsigned r = 1; r < options.repeat; ++r) best = std::min(best, run(allocator, workload, options));
+            line += std::format(" {:>16.1f}", best);
+        }
+        std::puts(line.c_str());
+    }
+    return 0;
+}
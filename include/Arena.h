@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+
+namespace utl {
+
+    namespace details {
+        template <size_t N>
+        struct InlineArenaStorage {
+            alignas(std::max_align_t) std::byte m_storage[N];
+        };
+    }
+
+    // Bump allocator over a chain of blocks, exposed as a std::pmr::memory_resource.
+    // Individual deallocations are (mostly) no-ops; everything is released at once with reset().
+    // Not thread-safe, use one arena per request/thread.
+    class Arena : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t defaultBlockSize = 64 * 1024;
+
+        explicit Arena(size_t blockSize = defaultBlockSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+            : m_upstream(upstream), m_blockSize(std::max(blockSize, minBlockSize)) {
+        }
+
+        // Serve allocations from initialBuffer first, only going upstream once it is exhausted
+        explicit Arena(std::span<std::byte> initialBuffer, size_t blockSize = defaultBlockSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+            : m_upstream(upstream), m_blockSize(std::max(blockSize, minBlockSize)),
+            m_initialBegin(initialBuffer.data()), m_initialEnd(initialBuffer.data() + initialBuffer.size()),
+            m_ptr(m_initialBegin), m_end(m_initialEnd) {
+        }
+
+        ~Arena() override { release(); }
+
+        Arena(const Arena&) = delete;
+        Arena(Arena&&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        Arena& operator=(Arena&&) = delete;
+
+        // Construct a T inside the arena. The destructor is never run, so only trivially destructible types are allowed
+        template <typename T, typename... Args>
+            requires std::is_trivially_destructible_v<T>
+        T* make(Args&&... args) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        // Uninitialized storage for count elements of T
+        template <typename T>
+        T* makeArray(size_t count) {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Rewind to the first block in O(1). Upstream blocks are kept and reused by later allocations
+        void reset() noexcept {
+            m_current = nullptr;
+            m_ptr = m_initialBegin;
+            m_end = m_initialEnd;
+            m_used = 0;
+            if (!m_initialBegin && m_head) {
+                enterBlock(m_head);
+            }
+        }
+
+        // Rewind and hand every upstream block back
+        void release() noexcept {
+            Block* block = m_head;
+            while (block) {
+                Block* next = block->next;
+                m_upstream->deallocate(block, block->size, alignof(Block));
+                block = next;
+            }
+            m_head = nullptr;
+            m_reserved = 0;
+            reset();
+        }
+
+        size_t bytesUsed() const noexcept { return m_used; }
+        size_t bytesReserved() const noexcept { return m_reserved + static_cast<size_t>(m_initialEnd - m_initialBegin); }
+        size_t blockSize() const noexcept { return m_blockSize; }
+        std::pmr::memory_resource* upstream() const noexcept { return m_upstream; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (void* ptr = bumpAllocate(bytes, alignment)) {
+                return ptr;
+            }
+
+            // Try the blocks retained from before the last reset(), then go upstream
+            while (m_current ? m_current->next : m_head) {
+                enterBlock(m_current ? m_current->next : m_head);
+                if (void* ptr = bumpAllocate(bytes, alignment)) {
+                    return ptr;
+                }
+            }
+            enterBlock(allocateBlock(bytes + alignment));
+            return bumpAllocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t) override {
+            // Roll back the most recent allocation, which makes grow-in-place patterns (vector, string) cheap
+            if (static_cast<std::byte*>(ptr) + bytes == m_ptr) {
+                m_ptr = static_cast<std::byte*>(ptr);
+                m_used -= bytes;
+            }
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct Block {
+            Block* next;
+            size_t size;
+        };
+        static constexpr size_t minBlockSize = 256;
+
+        std::pmr::memory_resource* m_upstream;
+        size_t m_blockSize;
+
+        std::byte* m_initialBegin{ nullptr };
+        std::byte* m_initialEnd{ nullptr };
+
+        Block* m_head{ nullptr };
+        Block* m_current{ nullptr };
+        std::byte* m_ptr{ nullptr };
+        std::byte* m_end{ nullptr };
+
+        size_t m_used{ 0 };
+        size_t m_reserved{ 0 };
+
+        void* bumpAllocate(size_t bytes, size_t alignment) noexcept {
+            const auto address = reinterpret_cast<uintptr_t>(m_ptr);
+            const uintptr_t aligned = (address + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+            const size_t padding = aligned - address;
+            if (!m_ptr || padding + bytes > static_cast<size_t>(m_end - m_ptr)) {
+                return nullptr;
+            }
+            m_ptr += padding + bytes;
+            m_used += bytes;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        void enterBlock(Block* block) noexcept {
+            m_current = block;
+            m_ptr = reinterpret_cast<std::byte*>(block + 1);
+            m_end = reinterpret_cast<std::byte*>(block) + block->size;
+        }
+
+        // Link a new block right after the current one so the retained chain stays in order
+        Block* allocateBlock(size_t minPayload) {
+            const size_t size = std::max(m_blockSize, minPayload + sizeof(Block));
+            auto* block = static_cast<Block*>(m_upstream->allocate(size, alignof(Block)));
+            block->size = size;
+            if (m_current) {
+                block->next = m_current->next;
+                m_current->next = block;
+            }
+            else {
+                block->next = m_head;
+                m_head = block;
+            }
+            m_reserved += size;
+            return block;
+        }
+    };
+
+
+    // Arena whose first N bytes live inside the object itself, e.g. on the stack
+    template <size_t N>
+    class InlineArena : private details::InlineArenaStorage<N>, public Arena {
+    public:
+        explicit InlineArena(size_t blockSize = defaultBlockSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+            : Arena(std::span<std::byte>(this->m_storage, N), blockSize, upstream) {
+        }
+    };
+
+}
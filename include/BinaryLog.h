@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LogRecord.h"
+
+namespace Debug
+{
+    // Binary log layout, host byte order (the header carries an endianness check):
+    //   header  : magic[8] "UTLBLOG\0", u32 version, u32 0x01020304, i64 opened at (system_clock ns)
+    //   Site    : u8 1, u32 id, u8 type, u32 line, u32 column, u16 len + file, u16 len + format,
+    //             u8 channel (version 4, 0 is the logger's own)
+    //   Record  : u8 2, u32 site, i64 timestamp, u8 argCount, u16 size + serialized args
+    //   Text    : u8 3, u32 site, i64 timestamp, u32 len + preformatted message
+    //   Dropped : u8 4, u32 thread index, u64 count
+    //   Suppressed : u8 5, u8 type, u32 line, u32 column, u16 len + file, u64 count (rate limited logs),
+    //                i64 timestamp (version 3)
+    //   Channel : u8 6, u8 id, u16 len + name, written before the first site of a channel (version 4)
+    // Timestamps are system_clock ns since the epoch, taken when the log was captured (version 3)
+    // or when the logger wrote it (before)
+    // Site metadata is written once, the first time a call site logs
+    namespace BinaryLog
+    {
+        constexpr char magic[8] = { 'U', 'T', 'L', 'B', 'L', 'O', 'G', '\0' };
+        constexpr uint32_t version = 4;   // 2 added Suppressed, 3 per-record timestamps, 4 channels. Readers accept every version up to this one
+        constexpr uint32_t endianCheck = 0x01020304;
+
+        enum class Frame : uint8_t
+        {
+            Site = 1,
+            Record = 2,
+            Text = 3,
+            Dropped = 4,
+            Suppressed = 5,
+            Channel = 6
+        };
+    }
+
+    class BinaryLogWriter
+    {
+    public:
+        // Throws std::runtime_error when the file cannot be opened
+        explicit BinaryLogWriter(const std::filesystem::path& path);
+        ~BinaryLogWriter();
+
+        BinaryLogWriter(const BinaryLogWriter&) = delete;
+        BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+        // channel names record.channel, it is only written the first time the channel shows up
+        void write(const LogRecord& record, int64_t timestamp, std::string_view channel = {});
+        void writeDropped(uint32_t threadIndex, uint64_t count);
+        void writeSuppressed(Log::Type type, std::string_view file, uint32_t line, uint32_t column, uint64_t count, int64_t timestamp);
+        // Hand the buffered frames to the file
+        void flush();
+
+    private:
+        struct SiteKey
+        {
+            const char* format;
+            const char* file;
+            uint32_t line;
+            uint32_t column;
+            Log::Type type;
+            uint8_t channel;
+            bool operator==(const SiteKey&) const = default;
+        };
+        struct SiteKeyHash
+        {
+            size_t operator()(const SiteKey& key) const noexcept;
+        };
+
+        std::ofstream m_file;
+        std::vector<char> m_buffer;
+        std::unordered_map<SiteKey, uint32_t, SiteKeyHash> m_sites;
+        std::array<bool, 256> m_channels{};     // Channel frame written
+
+        uint32_t siteId(const LogRecord& record, std::string_view channel);
+    };
+
+    // Binary log writer for crash dumps, async-signal-safe: a fixed buffer flushed with write(2),
+    // no allocation and no locks. Every record gets its own Site frame, there is no room for a
+    // site table
+    class BinaryLogDumpWriter
+    {
+    public:
+        BinaryLogDumpWriter(int fd, int64_t openedAt) noexcept;
+        ~BinaryLogDumpWriter() { flush(); }
+
+        BinaryLogDumpWriter(const BinaryLogDumpWriter&) = delete;
+        BinaryLogDumpWriter& operator=(const BinaryLogDumpWriter&) = delete;
+
+        void write(const LogRecord& record, int64_t timestamp) noexcept;
+        void writeChannel(uint8_t id, std::string_view name) noexcept;
+        // False once any write failed
+        bool flush() noexcept;
+
+    private:
+        int m_fd;
+        uint32_t m_sites = 0;
+        size_t m_size = 0;
+        bool m_failed = false;
+        char m_buffer[4096];
+
+        void put(const void* bytes, size_t size) noexcept;
+        template <typename T>
+        void put(const T& value) noexcept { put(&value, sizeof(T)); }
+        template <typename Length>
+        void putString(const char* str, size_t size) noexcept;
+    };
+
+    // Reads a binary log back and renders it in the logger's text layout
+    class BinaryLogReader
+    {
+    public:
+        // Throws std::runtime_error when the stream is not a binary log
+        explicit BinaryLogReader(std::istream& in);
+
+        // Append the next message as text to out, false at the end of the log.
+        // Throws std::runtime_error on a truncated or corrupt log
+        bool next(std::vector<char>& out);
+
+        int64_t openedAt() const noexcept { return m_openedAt; }
+        // Channel of the message next() returned last, empty for the logger's own
+        std::string_view channel() const noexcept { return m_channel; }
+
+    private:
+        struct Site
+        {
+            Log::Type type;
+            uint32_t line;
+            uint32_t column;
+            std::string file;
+            std::string format;
+            uint8_t channel = 0;
+        };
+
+        std::istream& m_in;
+        int64_t m_openedAt = 0;
+        uint32_t m_version = 0;
+        std::vector<Site> m_sites;
+        std::array<std::string, 256> m_channelNames;
+        std::string_view m_channel;
+        std::vector<std::byte> m_payload;
+        std::string m_text;
+        const Site* m_prevSite = nullptr;
+
+        const Site& siteAt(uint32_t id) const;
+        void prefix(std::vector<char>& out, const Site& site, int64_t timestamp);
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace utl {
+
+    // Byte ring buffer whose storage is mapped twice back to back in virtual memory, so any
+    // window of up to capacity() bytes is contiguous even when it wraps around the end.
+    // Safe for one producer thread and one consumer thread.
+    //
+    //   auto window = ring.reserve(frameSize);   // producer
+    //   ... write into window ...
+    //   ring.commit(frameSize);
+    //
+    //   auto bytes = ring.peek();                // consumer
+    //   ring.consume(parseFrames(bytes));
+    class ByteRing {
+    public:
+        // Capacity is rounded up to a power of two multiple of the OS allocation granularity.
+        // Throws std::runtime_error if the double mapping cannot be created
+        explicit ByteRing(size_t minCapacity);
+        ~ByteRing();
+
+        ByteRing(const ByteRing&) = delete;
+        ByteRing& operator=(const ByteRing&) = delete;
+        // A moved-from ring has no storage: capacity 0, every reserve is empty and write/read fail
+        ByteRing(ByteRing&& other) noexcept;
+        ByteRing& operator=(ByteRing&& other) noexcept;
+
+        // Producer: contiguous writable window of exactly bytes, empty if there is not enough free space
+        std::span<std::byte> reserve(size_t bytes) noexcept {
+            if (bytes > freeSpace()) return {};
+            return { m_base + (m_tail.load(std::memory_order_relaxed) & m_mask), bytes };
+        }
+        // Producer: the whole free space as one window
+        std::span<std::byte> writable() noexcept {
+            return { m_base + (m_tail.load(std::memory_order_relaxed) & m_mask), freeSpace() };
+        }
+        // Producer: publish bytes written into the last reserved window
+        void commit(size_t bytes) noexcept {
+            m_tail.store(m_tail.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+        }
+
+        // Consumer: every readable byte as one window
+        std::span<const std::byte> peek() const noexcept {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            return { m_base + (head & m_mask), m_tail.load(std::memory_order_acquire) - head };
+        }
+        // Consumer: release bytes from the front
+        void consume(size_t bytes) noexcept {
+            m_head.store(m_head.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+        }
+
+        // Copying helpers, all or nothing
+        bool write(std::span<const std::byte> bytes) noexcept;
+        bool read(std::span<std::byte> out) noexcept;
+
+        bool valid() const noexcept { return m_base != nullptr; }
+        size_t capacity() const noexcept { return m_base ? m_mask + 1 : 0; }
+        size_t size() const noexcept { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+        size_t freeSpace() const noexcept { return capacity() - size(); }
+        bool isEmpty() const noexcept { return size() == 0; }
+
+    private:
+        std::byte* m_base{ nullptr };
+        size_t m_mask{ 0 };
+        alignas(64) std::atomic_size_t m_head{ 0 }; // total bytes consumed
+        alignas(64) std::atomic_size_t m_tail{ 0 }; // total bytes committed
+
+        void unmap() noexcept;
+    };
+
+}
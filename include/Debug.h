@@ -15,13 +15,38 @@ namespace Debug
     }
 
 
+    inline bool IsEnabled(Log::Type logType)
+    {
+        static Logger& logger = Logger::Instance();
+        return IsCompiledIn(logType) && logger.isEnabled(logType);
+    }
+
+    // Arguments are captured in binary and formatted later on the logger thread.
+    // Masked out types return before anything is captured
     template <typename... Args>
-    inline void LogMessage(Log::Type logType, Log& fmt, Args&&... args)
+    inline void LogMessage(Log::Type logType, FormatStringFor<Args...> fmt, Args&&... args)
     {
         static Logger& logger = Logger::Instance();
-        fmt.Apply(std::forward<Args>(args)...);
-        fmt.type = logType;
-        logger.addLog(fmt);
+        logger.log(logType, fmt.format, fmt.source, args...);
+    }
+
+    // Named channel, registered on first use. Cache the reference, the lookup takes a lock:
+    // static auto& net = Debug::Channel("net"); Debug::Info(net, "...");
+    inline LogChannel& Channel(utl::StringHash name)
+    {
+        return Logger::Instance().channel(name);
+    }
+
+    inline bool IsEnabled(const LogChannel& channel, Log::Type logType)
+    {
+        return IsCompiledIn(logType) && channel.isEnabled(logType);
+    }
+
+    template <typename... Args>
+    inline void LogMessage(const LogChannel& channel, Log::Type logType, FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        static Logger& logger = Logger::Instance();
+        logger.log(channel, logType, fmt.format, fmt.source, args...);
     }
 
     inline void Flush()
@@ -31,62 +56,114 @@ namespace Debug
     }
 
     template <typename... Args>
-    inline void Info(Log fmt, Args&&... args)
+    inline void Trace(FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::Trace)) LogMessage(Log::Type::Trace, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    inline void Trace(const LogChannel& channel, FormatStringFor<Args...> fmt, Args&&... args)
     {
-        LogMessage(Log::Type::Info, fmt, std::forward<Args>(args)...);
+        if constexpr (IsCompiledIn(Log::Type::Trace)) LogMessage(channel, Log::Type::Trace, fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
-    inline void Warning(Log fmt, Args&&... args)
+    inline void Info(FormatStringFor<Args...> fmt, Args&&... args)
     {
-        LogMessage(Log::Type::Warning, fmt, std::forward<Args>(args)...);
+        if constexpr (IsCompiledIn(Log::Type::Info)) LogMessage(Log::Type::Info, fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
-    inline void Error(Log fmt, Args&&... args)
+    inline void Info(const LogChannel& channel, FormatStringFor<Args...> fmt, Args&&... args)
     {
-        LogMessage(Log::Type::Error, fmt, std::forward<Args>(args)...);
+        if constexpr (IsCompiledIn(Log::Type::Info)) LogMessage(channel, Log::Type::Info, fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
-    inline void FatalError(Log fmt, Args&&... args)
+    inline void Warning(FormatStringFor<Args...> fmt, Args&&... args)
     {
-        LogMessage(Log::Type::FatalError, fmt, std::forward<Args>(args)...);
+        if constexpr (IsCompiledIn(Log::Type::Warning)) LogMessage(Log::Type::Warning, fmt, std::forward<Args>(args)...);
     }
+
     template <typename... Args>
-    inline void Exception(Log fmt, Args&&... args)
+    inline void Warning(const LogChannel& channel, FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::Warning)) LogMessage(channel, Log::Type::Warning, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    inline void Error(FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::Error)) LogMessage(Log::Type::Error, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    inline void Error(const LogChannel& channel, FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::Error)) LogMessage(channel, Log::Type::Error, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    inline void FatalError(FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::FatalError)) LogMessage(Log::Type::FatalError, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    inline void FatalError(const LogChannel& channel, FormatStringFor<Args...> fmt, Args&&... args)
+    {
+        if constexpr (IsCompiledIn(Log::Type::FatalError)) LogMessage(channel, Log::Type::FatalError, fmt, std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    inline void Exception(FormatStringFor<Args...> fmt, Args&&... args)
     {
         LogMessage(Log::Type::Exception, fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
-    inline void Throw(Log fmt, Args&&... args)
+    inline void Throw(FormatStringFor<Args...> fmt, Args&&... args)
     {
-        fmt.Apply(std::forward<Args>(args)...);
-        throw std::runtime_error(fmt.message);
+        throw std::runtime_error(FormatText(fmt.format, args...));
     }
 
     template <typename... Args>
-    inline void Assert(bool condition, Log fmt, Args&&... args)
+    inline void Assert(bool condition, FormatStringFor<Args...> fmt, Args&&... args)
     {
         if (!condition) {
-            fmt.Apply(std::forward<Args>(args)...);
-            fmt.type = Log::Type::FatalError;
-            fmt.message = std::format("\nAssertion failed at {}:{} in {}\n", fmt.source.file_name(), fmt.source.line(), fmt.source.function_name());
             LogMessage(Log::Type::Assert, fmt, std::forward<Args>(args)...);
+            Flush();
             std::abort(); 
         }
     }
     template <typename... Args>
-    inline void AssertThrow(bool condition, Log fmt, Args&&... args)
+    inline void AssertThrow(bool condition, FormatStringFor<Args...> fmt, Args&&... args)
     {
         if (!condition) {
-            fmt.Apply(std::forward<Args>(args)...);
-            fmt.type = Log::Type::FatalError;
-            fmt.message = std::format("\nAssertion failed at {}:{} in {}: {}\n",fmt.source.file_name(),fmt.source.line(),fmt.source.function_name(),fmt.message);
-            PrintOut(fmt, std::cerr); 
-            throw std::runtime_error(fmt.message);
+            Log log(FormatText(fmt.format, args...), Log::Type::FatalError, fmt.source);
+            log.message = std::format("\nAssertion failed at {}:{} in {}: {}\n", log.source.file_name(), log.source.line(), log.source.function_name(), log.message);
+            PrintOut(log, std::cerr); 
+            throw std::runtime_error(log.message);
 
         }
     }
-}
\ No newline at end of file
+}
+
+// Like the functions above, but compiled-out or masked calls do not evaluate their arguments either
+#define UTL_LOG_IF_ENABLED(type, function, ...) \
+    do { if constexpr (::Debug::IsCompiledIn(type)) { if (::Debug::IsEnabled(type)) function(__VA_ARGS__); } } while (0)
+#define UTL_TRACE(...) UTL_LOG_IF_ENABLED(::Debug::Log::Type::Trace, ::Debug::Trace, __VA_ARGS__)
+#define UTL_INFO(...) UTL_LOG_IF_ENABLED(::Debug::Log::Type::Info, ::Debug::Info, __VA_ARGS__)
+#define UTL_WARNING(...) UTL_LOG_IF_ENABLED(::Debug::Log::Type::Warning, ::Debug::Warning, __VA_ARGS__)
+#define UTL_ERROR(...) UTL_LOG_IF_ENABLED(::Debug::Log::Type::Error, ::Debug::Error, __VA_ARGS__)
+#define UTL_FATAL_ERROR(...) UTL_LOG_IF_ENABLED(::Debug::Log::Type::FatalError, ::Debug::FatalError, __VA_ARGS__)
+
+// Channel versions, the channel is looked up once per call site: UTL_CHANNEL_INFO("net", "sent {}", n)
+#define UTL_CHANNEL_LOG_IF_ENABLED(channelName, type, function, ...) \
+    do { if constexpr (::Debug::IsCompiledIn(type)) { \
+        static ::Debug::LogChannel& utlChannel = ::Debug::Channel(channelName); \
+        if (utlChannel.isEnabled(type)) function(utlChannel, __VA_ARGS__); } } while (0)
+#define UTL_CHANNEL_TRACE(channelName, ...) UTL_CHANNEL_LOG_IF_ENABLED(channelName, ::Debug::Log::Type::Trace, ::Debug::Trace, __VA_ARGS__)
+#define UTL_CHANNEL_INFO(channelName, ...) UTL_CHANNEL_LOG_IF_ENABLED(channelName, ::Debug::Log::Type::Info, ::Debug::Info, __VA_ARGS__)
+#define UTL_CHANNEL_WARNING(channelName, ...) UTL_CHANNEL_LOG_IF_ENABLED(channelName, ::Debug::Log::Type::Warning, ::Debug::Warning, __VA_ARGS__)
+#define UTL_CHANNEL_ERROR(channelName, ...) UTL_CHANNEL_LOG_IF_ENABLED(channelName, ::Debug::Log::Type::Error, ::Debug::Error, __VA_ARGS__)
+#define UTL_CHANNEL_FATAL_ERROR(channelName, ...) UTL_CHANNEL_LOG_IF_ENABLED(channelName, ::Debug::Log::Type::FatalError, ::Debug::FatalError, __VA_ARGS__)
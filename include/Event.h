@@ -6,7 +6,8 @@
 #include <memory>
 #include <shared_mutex>
 #include <unordered_map>
-#include <vector>
+
+#include "SmallVector.h"
 
 namespace utl {
 
@@ -53,7 +54,7 @@ namespace utl {
     class Event : public std::enable_shared_from_this<Event<Args...>> {
     public:
         using HandlerType = EventHandler<Args...>;
-        using HandlerCollectionType = std::vector<HandlerType>;
+        using HandlerCollectionType = utl::SmallVector<HandlerType, 4>;
         using HandlerIndexMapType = std::unordered_map<typename HandlerType::IdType, std::size_t>;
 
         class Connection {
@@ -0,0 +1,19 @@
+#pragma once
+#include <filesystem>
+
+namespace Debug
+{
+    // Crash handling for the logger's flight recorder (Logger::dumpFlightRecorder).
+    // Installs handlers for SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT (an unhandled exception
+    // filter and SIGABRT on Windows). On a crash the handler freezes the logger (Logger::freeze),
+    // writes the recent records of every thread to dumpPath as a binary log (decode it with
+    // myutils-logdecode), then hands the signal on to the previous handler. The calling thread
+    // also gets an alternate signal stack, so a stack overflow on it can still be dumped.
+    // The record slots themselves live in process memory, they are not mmap-backed: records
+    // point at format strings and call sites of the running binary, so a mapped copy could not
+    // be decoded after the process is gone. For text that survives even SIGKILL, add a
+    // MappedRingLogSink as well.
+    // Throws std::runtime_error when the handlers cannot be installed
+    void InstallCrashHandlers(const std::filesystem::path& dumpPath);
+    void UninstallCrashHandlers() noexcept;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+#include "TimerStats.h"
+
+namespace utl {
+
+    // Per-frame allocation statistics, recorded when a frame's buffer is rotated out
+    struct FrameAllocatorStats {
+        uint64_t frame{ 0 };
+        size_t peakBytes{ 0 };      // bytes bumped out of the frame buffer (including alignment padding)
+        size_t overflowBytes{ 0 };  // bytes that did not fit and went upstream
+        size_t allocations{ 0 };
+    };
+
+    // N-buffered linear allocator for per-frame temporaries, rotated by exp::Clock::update().
+    // Memory handed out during frame F stays valid until frame F + Buffers - 1 ends, so the
+    // default of 2 buffers keeps the current and the previous frame alive.
+    // Not thread-safe, use one per thread.
+    template <size_t Buffers = 2>
+        requires (Buffers >= 2)
+    class FrameAllocator : public std::pmr::memory_resource {
+    public:
+        FrameAllocator(const exp::Clock& clock, size_t bytesPerFrame, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : m_clock(clock), m_upstream(upstream), m_bufferSize(bytesPerFrame), m_frame(clock.getFrameCount()) {
+            for (auto& buffer : m_buffers) {
+                buffer.data = static_cast<std::byte*>(m_upstream->allocate(m_bufferSize, alignof(std::max_align_t)));
+            }
+            m_lastStats.frame = m_frame;
+        }
+
+        ~FrameAllocator() override {
+            for (auto& buffer : m_buffers) {
+                releaseOverflow(buffer);
+                m_upstream->deallocate(buffer.data, m_bufferSize, alignof(std::max_align_t));
+            }
+        }
+
+        FrameAllocator(const FrameAllocator&) = delete;
+        FrameAllocator(FrameAllocator&&) = delete;
+        FrameAllocator& operator=(const FrameAllocator&) = delete;
+        FrameAllocator& operator=(FrameAllocator&&) = delete;
+
+        // Uninitialized storage for count elements of T, valid for this and the next Buffers - 1 frames
+        template <typename T>
+        T* makeArray(size_t count) {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        template <typename T, typename... Args>
+            requires std::is_trivially_destructible_v<T>
+        T* make(Args&&... args) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        // Rotate now if the clock advanced. Called implicitly by every allocation
+        void sync() {
+            const uint64_t frame = m_clock.getFrameCount();
+            if (frame == m_frame) return;
+
+            auto& buffer = m_buffers[m_index];
+            m_lastStats = { m_frame, buffer.offset, buffer.overflowBytes, buffer.allocations };
+            m_peakBytes = std::max(m_peakBytes, buffer.offset);
+            m_peakOverflowBytes = std::max(m_peakOverflowBytes, buffer.overflowBytes);
+
+            m_frame = frame;
+            m_index = (m_index + 1) % Buffers;
+            recycle(m_buffers[m_index]);
+        }
+
+        // Stats of the most recently completed frame
+        const FrameAllocatorStats& lastFrameStats() const noexcept { return m_lastStats; }
+        // Stats of the frame currently being filled
+        FrameAllocatorStats currentFrameStats() const noexcept {
+            const auto& buffer = m_buffers[m_index];
+            return { m_frame, buffer.offset, buffer.overflowBytes, buffer.allocations };
+        }
+        size_t peakBytes() const noexcept { return m_peakBytes; }
+        size_t peakOverflowBytes() const noexcept { return m_peakOverflowBytes; }
+        size_t bufferSize() const noexcept { return m_bufferSize; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            sync();
+            auto& buffer = m_buffers[m_index];
+            ++buffer.allocations;
+
+            // Align the address, the buffer itself is only max_align_t aligned
+            const auto address = reinterpret_cast<uintptr_t>(buffer.data) + buffer.offset;
+            const uintptr_t aligned = (address + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+            const size_t offset = aligned - reinterpret_cast<uintptr_t>(buffer.data);
+            if (offset + bytes <= m_bufferSize) {
+                buffer.offset = offset + bytes;
+                return buffer.data + offset;
+            }
+
+            // Overflow goes upstream and is released when this buffer comes around again
+            void* ptr = m_upstream->allocate(bytes, alignment);
+            buffer.overflow.push_back({ ptr, bytes, alignment });
+            buffer.overflowBytes += bytes;
+            return ptr;
+        }
+
+        // Frame memory is reclaimed in bulk on rotation
+        void do_deallocate(void*, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct OverflowBlock {
+            void* ptr;
+            size_t bytes;
+            size_t alignment;
+        };
+        struct Buffer {
+            std::byte* data{ nullptr };
+            size_t offset{ 0 };
+            size_t allocations{ 0 };
+            size_t overflowBytes{ 0 };
+            std::vector<OverflowBlock> overflow{};
+        };
+
+        const exp::Clock& m_clock;
+        std::pmr::memory_resource* m_upstream;
+        size_t m_bufferSize;
+
+        std::array<Buffer, Buffers> m_buffers{};
+        size_t m_index{ 0 };
+        uint64_t m_frame;
+
+        FrameAllocatorStats m_lastStats{};
+        size_t m_peakBytes{ 0 };
+        size_t m_peakOverflowBytes{ 0 };
+
+        void releaseOverflow(Buffer& buffer) noexcept {
+            for (const auto& block : buffer.overflow) {
+                m_upstream->deallocate(block.ptr, block.bytes, block.alignment);
+            }
+            buffer.overflow.clear();
+        }
+
+        void recycle(Buffer& buffer) noexcept {
+            releaseOverflow(buffer);
+            buffer.offset = 0;
+            buffer.allocations = 0;
+            buffer.overflowBytes = 0;
+        }
+    };
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace utl {
+
+    // Sampling heap profiler. On average one allocation every sampleInterval bytes (Poisson sampling)
+    // records its call stack; the sample is dropped again when that allocation is freed.
+    // Samples come from the HeapTracker operator new/delete overrides, so it needs UTL_ENABLE_HEAP_TRACKER.
+    class HeapProfiler {
+    public:
+        static constexpr size_t maxFrames = 32;
+        static constexpr size_t defaultSampleInterval = 512 * 1024;
+
+        static void start(size_t sampleInterval = defaultSampleInterval) noexcept;
+        static void stop() noexcept;
+        // Drop every recorded sample
+        static void reset();
+        static bool isRunning() noexcept;
+        static size_t sampleInterval() noexcept;
+
+        // One line per call stack, "outermost;...;innermost <bytes>", for flamegraph.pl and friends.
+        // Bytes are estimates of the real totals: every sample of size s is weighted by
+        // s / (1 - exp(-s / sampleInterval)), so small allocations are not under-reported.
+        // inUse selects live bytes, otherwise everything allocated since start()
+        static void writeFolded(std::ostream& os, bool inUse = true);
+        // Legacy gperftools heap profile text ("heap profile: ... @ heap_v2/<interval>"), readable by pprof
+        static void writePprof(std::ostream& os);
+
+        // Hooks used by the operator new/delete overrides
+        static void onAllocation(void* ptr, size_t bytes) noexcept;
+        static void onFree(void* ptr) noexcept;
+    };
+
+}
@@ -1 +1,83 @@
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "StringHash.h"
+
+namespace utl {
+
+    // Low-overhead global allocation accounting.
+    // The global operator new/delete overrides are opt-in: build with UTL_ENABLE_HEAP_TRACKER
+    // (CMake option MYUTILS_HEAP_TRACKER) and reference HeapTracker somewhere so the linker keeps it.
+    // Counters are gathered per thread and folded into the global totals every few allocations,
+    // so snapshots may lag by a few KB per thread.
+    class HeapTracker {
+    public:
+        static constexpr size_t maxTags = 64;
+
+        struct Snapshot {
+            uint64_t allocatedBytes{ 0 };
+            uint64_t freedBytes{ 0 };
+            uint64_t allocations{ 0 };
+            uint64_t frees{ 0 };
+            uint64_t peakBytes{ 0 };
+            std::chrono::steady_clock::time_point time{};
+
+            inline uint64_t liveBytes() const noexcept { return allocatedBytes - freedBytes; }
+            inline uint64_t liveAllocations() const noexcept { return allocations - frees; }
+        };
+
+        struct Rate {
+            double bytesPerSecond{ 0.0 };
+            double allocationsPerSecond{ 0.0 };
+            double freesPerSecond{ 0.0 };
+        };
+
+        // Allocation volume attributed to a Scope tag. Frees are not attributed
+        struct TagStats {
+            std::string_view name{};
+            uint64_t allocatedBytes{ 0 };
+            uint64_t allocations{ 0 };
+        };
+
+        // Attribute allocations made by this thread to a tag until the scope ends. Scopes nest
+        class Scope {
+        public:
+            explicit Scope(StringHash tag) noexcept;
+            ~Scope() noexcept;
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            uint32_t m_previous;
+        };
+
+        // True when the operator new/delete overrides are compiled in
+        static constexpr bool isEnabled() noexcept {
+#ifdef UTL_ENABLE_HEAP_TRACKER
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Totals across all threads. Folds the calling thread's pending counters first
+        static Snapshot snapshot() noexcept;
+        static Rate rate(const Snapshot& from, const Snapshot& to) noexcept;
+        // Fill out with the registered tags, returns how many were written. Tag 0 is "untagged"
+        static size_t tagStats(std::span<TagStats> out) noexcept;
+
+        // Fold this thread's pending counters into the global totals
+        static void flushThread() noexcept;
+
+        // Accounting hooks used by the operator new/delete overrides, also usable by custom allocators
+        static void recordAllocation(size_t bytes) noexcept;
+        static void recordFree(size_t bytes) noexcept;
+    };
+
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "Slice.h"
+#include "ThreadPool.h"
+
+namespace utl {
+
+    namespace details {
+        // Split [0, count) into one contiguous range per pool thread and wait for all of them
+        template <typename F>
+        void parallelRanges(ThreadPool& pool, size_t count, F&& function) {
+            if (count == 0) return;
+            const size_t chunks = std::clamp<size_t>(pool.threadCount(), 1, count);
+            const size_t base = count / chunks;
+            const size_t rem = count % chunks;
+            std::vector<std::future<void>> futures;
+            futures.reserve(chunks);
+            for (size_t i = 0, begin = 0; i < chunks; ++i) {
+                const size_t end = begin + base + (i < rem ? 1 : 0);
+                futures.push_back(pool.enqueue([&function, begin, end] { function(begin, end); }));
+                begin = end;
+            }
+            for (auto& future : futures) future.get();
+        }
+
+        // Make room for count more elements in out. values may point into out itself, it is moved
+        // along when out reallocates. Grows geometrically, reserving the exact size on every append
+        // would make repeated appends quadratic
+        template <typename T>
+        void reserveFor(std::vector<T>& out, const T*& values, size_t count) {
+            const size_t needed = out.size() + count;
+            if (needed <= out.capacity()) return;
+            const T* begin = out.data();
+            const bool inside = !std::less<>{}(values, begin) && std::less<>{}(values, begin + out.size());
+            out.reserve(std::max(needed, out.capacity() * 2));
+            if (inside) values = out.data() + (values - begin);
+        }
+
+        // out.insert(out.end(), values, values + count), except values may be part of out
+        template <typename T>
+        void appendCopies(std::vector<T>& out, const T* values, size_t count) {
+            reserveFor(out, values, count);
+            for (size_t i = 0; i < count; ++i) out.push_back(values[i]);
+        }
+
+        // offsets[0] = 0, offsets[i + 1] = offsets[i] + sizes[i]
+        template <typename SizeFn>
+        std::vector<size_t> buildOffsets(ThreadPool& pool, size_t sliceCount, SizeFn& sizeOf) {
+            std::vector<size_t> offsets(sliceCount + 1, 0);
+            parallelRanges(pool, sliceCount, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) offsets[i + 1] = sizeOf(i);
+                });
+            for (size_t i = 0; i < sliceCount; ++i) offsets[i + 1] += offsets[i];
+            return offsets;
+        }
+    }
+
+    // Growable jagged array: every slice lives back to back in one vector and is located through
+    // a prefix offset table, so slice i is [offsets[i], offsets[i + 1]).
+    template <typename T>
+    class JaggedArray {
+    public:
+        JaggedArray() = default;
+
+        // Build sliceCount slices on a thread pool. sizeOf(i) returns the length of slice i and
+        // fill(i, std::span<T>) writes it; both run in parallel over disjoint slices.
+        template <typename SizeFn, typename FillFn>
+            requires std::is_default_constructible_v<T>
+        static JaggedArray build(ThreadPool& pool, size_t sliceCount, SizeFn&& sizeOf, FillFn&& fill) {
+            JaggedArray result;
+            result.m_offsets = details::buildOffsets(pool, sliceCount, sizeOf);
+            result.m_data.resize(result.m_offsets.back());
+            details::parallelRanges(pool, sliceCount, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) fill(i, result[i]);
+                });
+            return result;
+        }
+
+        // Append one slice, returns its index
+        size_t add(std::initializer_list<T> slice) {
+            return add(std::span<const T>(slice.begin(), slice.size()));
+        }
+
+        // The slice may be a view of this array, e.g. add(array[0])
+        template <std::ranges::input_range R>
+        size_t add(R&& slice) {
+            if constexpr (std::ranges::contiguous_range<R> && std::ranges::sized_range<R>
+                && std::is_same_v<std::ranges::range_value_t<R>, T>) {
+                details::appendCopies(m_data, std::ranges::data(slice), std::ranges::size(slice));
+            }
+            else {
+                // Unknown ranges may read m_data lazily, take the values out before m_data grows
+                std::vector<T> values;
+                if constexpr (std::ranges::sized_range<R>) values.reserve(std::ranges::size(slice));
+                for (auto&& value : slice) values.push_back(std::forward<decltype(value)>(value));
+                m_data.insert(m_data.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+            }
+            m_offsets.push_back(m_data.size());
+            return m_offsets.size() - 2;
+        }
+
+        // Append one slice with each argument as an element
+        template <typename... Args>
+        size_t emplace(Args&&... args) {
+            // Constructed before m_data grows, an argument may refer to an element
+            std::array<T, sizeof...(Args)> values{ T(std::forward<Args>(args))... };
+            m_data.insert(m_data.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+            m_offsets.push_back(m_data.size());
+            return m_offsets.size() - 2;
+        }
+
+        // Bulk append: values holds the slices back to back, sizes their lengths. Either may point
+        // into this array
+        void append(std::span<const size_t> sizes, std::span<const T> values) {
+            size_t total = 0;
+            for (size_t size : sizes) total += size;
+            if (total != values.size()) throw std::invalid_argument("JaggedArray::append sizes do not add up to values");
+            const size_t* lengths = sizes.data();
+            details::reserveFor(m_offsets, lengths, sizes.size());
+            details::appendCopies(m_data, values.data(), values.size());
+            size_t offset = m_offsets.back();
+            for (size_t i = 0; i < sizes.size(); ++i) {
+                offset += lengths[i];
+                m_offsets.push_back(offset);
+            }
+        }
+
+        // other may be this array
+        void append(const JaggedArray& other) {
+            const size_t base = m_data.size();
+            const size_t slices = other.sliceCount();
+            details::appendCopies(m_data, other.m_data.data(), other.m_data.size());
+            const size_t* offsets = other.m_offsets.data();
+            details::reserveFor(m_offsets, offsets, slices);
+            for (size_t i = 1; i <= slices; ++i) {
+                m_offsets.push_back(base + offsets[i]);
+            }
+        }
+
+        void reserve(size_t slices, size_t elements) {
+            m_offsets.reserve(slices + 1);
+            m_data.reserve(elements);
+        }
+
+        void shrinkToFit() {
+            m_offsets.shrink_to_fit();
+            m_data.shrink_to_fit();
+        }
+
+        void clear() noexcept {
+            m_data.clear();
+            m_offsets.assign(1, 0);
+        }
+
+        // Remove the last slice
+        void popBack() {
+            if (m_offsets.size() < 2) return;
+            m_offsets.pop_back();
+            m_data.resize(m_offsets.back());
+        }
+
+        size_t sliceCount() const noexcept { return m_offsets.size() - 1; }
+        size_t size() const noexcept { return m_data.size(); }
+        bool empty() const noexcept { return sliceCount() == 0; }
+        size_t sliceSize(size_t index) const noexcept { return m_offsets[index + 1] - m_offsets[index]; }
+
+        std::span<T> operator[](size_t index) noexcept {
+            return { m_data.data() + m_offsets[index], sliceSize(index) };
+        }
+        std::span<const T> operator[](size_t index) const noexcept {
+            return { m_data.data() + m_offsets[index], sliceSize(index) };
+        }
+
+        // Bounds-checked access, empty span when out of range
+        std::span<T> get(size_t index) noexcept {
+            return index < sliceCount() ? (*this)[index] : std::span<T>{};
+        }
+        std::span<const T> get(size_t index) const noexcept {
+            return index < sliceCount() ? (*this)[index] : std::span<const T>{};
+        }
+
+        utl::Slice<T> getSlice(size_t index) noexcept {
+            auto span = get(index);
+            return { span.data(), span.size() };
+        }
+
+        // Every element of every slice, for passes that ignore slice boundaries
+        std::span<T> elements() noexcept { return m_data; }
+        std::span<const T> elements() const noexcept { return m_data; }
+        std::span<const size_t> offsets() const noexcept { return m_offsets; }
+
+        template <typename F>
+        void foreach(F&& function) {
+            for (size_t i = 0; i < sliceCount(); ++i) function((*this)[i]);
+        }
+
+    private:
+        std::vector<T> m_data{};
+        std::vector<size_t> m_offsets{ 0 };
+    };
+
+
+    // Structure-of-arrays jagged array: slice i spans [offsets[i], offsets[i + 1]) in every column,
+    // and each column is contiguous so columnar passes over all slices vectorize.
+    template <typename... Ts>
+        requires (sizeof...(Ts) > 0)
+    class JaggedSoA {
+    public:
+        static constexpr size_t columnCount = sizeof...(Ts);
+
+        JaggedSoA() = default;
+
+        // Parallel build, fill(i, std::span<Ts>...) writes every column of slice i
+        template <typename SizeFn, typename FillFn>
+        static JaggedSoA build(ThreadPool& pool, size_t sliceCount, SizeFn&& sizeOf, FillFn&& fill) {
+            JaggedSoA result;
+            result.m_offsets = details::buildOffsets(pool, sliceCount, sizeOf);
+            std::apply([&](auto&... columns) { (columns.resize(result.m_offsets.back()), ...); }, result.m_columns);
+            details::parallelRanges(pool, sliceCount, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    result.sliceApply(i, [&](auto... spans) { fill(i, spans...); });
+                }
+                });
+            return result;
+        }
+
+        // Append one slice given one equally sized span per column, returns its index
+        size_t add(std::span<const Ts>... columns) {
+            const size_t length = std::get<0>(std::forward_as_tuple(columns...)).size();
+            const bool sameLength = ((columns.size() == length) && ...);
+            if (!sameLength) throw std::invalid_argument("JaggedSoA::add column length mismatch");
+            // A column may be a slice of this array
+            std::apply([&](auto&... storage) { (details::appendCopies(storage, columns.data(), length), ...); }, m_columns);
+            m_offsets.push_back(m_offsets.back() + length);
+            return m_offsets.size() - 2;
+        }
+
+        void reserve(size_t slices, size_t elements) {
+            m_offsets.reserve(slices + 1);
+            std::apply([&](auto&... columns) { (columns.reserve(elements), ...); }, m_columns);
+        }
+
+        void clear() noexcept {
+            std::apply([](auto&... columns) { (columns.clear(), ...); }, m_columns);
+            m_offsets.assign(1, 0);
+        }
+
+        size_t sliceCount() const noexcept { return m_offsets.size() - 1; }
+        size_t size() const noexcept { return m_offsets.back(); }
+        bool empty() const noexcept { return sliceCount() == 0; }
+        size_t sliceSize(size_t index) const noexcept { return m_offsets[index + 1] - m_offsets[index]; }
+
+        // Column I of slice index
+        template <size_t I>
+        auto slice(size_t index) noexcept {
+            auto& column = std::get<I>(m_columns);
+            return std::span(column.data() + m_offsets[index], sliceSize(index));
+        }
+        template <size_t I>
+        auto slice(size_t index) const noexcept {
+            const auto& column = std::get<I>(m_columns);
+            return std::span(column.data() + m_offsets[index], sliceSize(index));
+        }
+
+        // Whole column I across all slices
+        template <size_t I>
+        auto column() noexcept { return std::span(std::get<I>(m_columns)); }
+        template <size_t I>
+        auto column() const noexcept { return std::span(std::get<I>(m_columns)); }
+
+        std::span<const size_t> offsets() const noexcept { return m_offsets; }
+
+        // Call function(std::span<Ts>...) with every column of slice index
+        template <typename F>
+        decltype(auto) sliceApply(size_t index, F&& function) {
+            const size_t offset = m_offsets[index];
+            const size_t length = sliceSize(index);
+            return std::apply([&](auto&... columns) {
+                return function(std::span(columns.data() + offset, length)...);
+                }, m_columns);
+        }
+
+    private:
+        std::tuple<std::vector<Ts>...> m_columns{};
+        std::vector<size_t> m_offsets{ 0 };
+    };
+
+}
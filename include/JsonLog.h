@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "LogRecord.h"
+
+namespace Debug
+{
+    // Streaming JSON-lines encoding for the logger thread. Every function appends one complete
+    // line to out, escaping as it copies, without building any intermediate document:
+    //   {"ts":<unix ns>,"level":"info","file":"a.cpp","line":3,"col":5,"thread":1,"msg":"...",<kv fields>}
+    // kv() fields keep their type (numbers, true/false, strings). Messages formatted on the calling
+    // thread (custom types, or too large for a record) carry their fields inside msg.
+    // Strings are copied as UTF-8 without validation.
+
+    // Quoted, escaped JSON string
+    void AppendJsonString(std::vector<char>& out, std::string_view str);
+    // Lower case level name, "fatal" for FatalError
+    std::string_view JsonLevelName(Log::Type type) noexcept;
+
+    // channel is left out when empty
+    void FormatJsonRecord(std::vector<char>& out, const LogRecord& record, int64_t timestamp, uint32_t threadIndex, std::string_view channel = {});
+    void FormatJsonDropNotice(std::vector<char>& out, uint64_t count, uint32_t threadIndex, int64_t timestamp);
+    void FormatJsonSuppressedNotice(std::vector<char>& out, Log::Type type, std::string_view file, uint32_t line, uint32_t column, uint64_t count, int64_t timestamp);
+}
@@ -4,8 +4,27 @@
 #include <source_location>
 #include <stdint.h>
 #include <string>
+#include <type_traits>
 namespace Debug
 {
+    // Compile-time format string plus the location of the call it was written at. The pointer is
+    // guaranteed to outlive the program, so formatting can be deferred to the logger thread
+    template <typename... Args>
+    struct FormatString
+    {
+        const char* format;
+        std::source_location source;
+
+        consteval FormatString(const char* fmt, const std::source_location& l = std::source_location::current())
+            : format(fmt), source(l)
+        {
+            [[maybe_unused]] std::format_string<Args...> check(fmt);
+        }
+    };
+
+    template <typename... Args>
+    using FormatStringFor = FormatString<std::type_identity_t<Args>...>;
+
     struct Log
     {
 
@@ -39,6 +58,21 @@ namespace Debug
         Debug::Log::Type::FatalError |
         Debug::Log::Type::Exception |
         Debug::Log::Type::Assert;
+
+    // Log calls below this level are compiled out entirely: 0 trace, 1 info, 2 warning, 3 error,
+    // 4 fatal error. Exceptions and asserts are always kept. Release builds drop trace by default
+#ifndef UTL_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define UTL_LOG_MIN_LEVEL 1
+#else
+#define UTL_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+    constexpr bool IsCompiledIn(Log::Type type) noexcept
+    {
+        return static_cast<int>(type) >= (1 << UTL_LOG_MIN_LEVEL);
+    }
 }
 template <typename... Args>
 inline void Debug::Log::Apply(Args &&...args)
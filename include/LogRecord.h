@@ -0,0 +1,235 @@
+#pragma once
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Log.h"
+
+namespace Debug
+{
+    // Tag byte in front of every serialized log argument
+    enum class ArgTag : uint8_t
+    {
+        Int64,
+        UInt64,
+        Float,
+        Double,
+        Bool,
+        Char,
+        String,     // uint16 length + bytes
+        Pointer,
+        Key         // uint16 length + field name, names the argument that follows it
+    };
+
+    // Structured field: Debug::Info("login", kv("user", id)). In text the field is appended as
+    // " user=42" (and a {} placeholder can still show its value), the JSON output gets "user":42
+    template <typename T>
+    struct KeyValue
+    {
+        std::string_view key;
+        std::conditional_t<std::is_scalar_v<T> || std::is_same_v<T, std::string_view>, T, const T&> value;
+    };
+
+    template <typename T>
+    auto kv(std::string_view key, const T& value)
+    {
+        if constexpr (std::convertible_to<const T&, std::string_view>) return KeyValue<std::string_view>{ key, std::string_view(value) };
+        else return KeyValue<T>{ key, value };
+    }
+
+    // One decoded payload argument, key is empty unless it came from kv()
+    struct LogArg
+    {
+        ArgTag tag{};
+        union {
+            int64_t i;
+            uint64_t u;
+            float f;
+            double d;
+            bool b;
+            char c;
+            const void* p;
+        };
+        std::string_view str{};
+        std::string_view key{};
+    };
+
+    struct LogRecordHeader
+    {
+        const char* format = nullptr;           // static format string the payload is rendered with
+        std::source_location source;
+        std::unique_ptr<std::string> text;      // message formatted by the caller when it did not fit the payload
+        uint64_t timestamp = 0;                 // utl::TscClock ticks at capture, converted on the logger thread
+        Log::Type type = Log::Type::None;
+        uint16_t payloadSize = 0;
+        uint8_t argCount = 0;
+        uint8_t channel = 0;                    // LogChannel id, 0 is the logger's own
+    };
+
+    // Fixed-size queue slot: call-site data plus the arguments serialized as tag + raw bytes,
+    // rendered later on the logger thread
+    struct LogRecord : LogRecordHeader
+    {
+        static constexpr size_t slotSize = 256;
+        static constexpr size_t maxArgs = 32;
+        std::array<std::byte, slotSize - sizeof(LogRecordHeader)> payload;
+    };
+
+    namespace details
+    {
+        template <typename T>
+        concept LogString = std::convertible_to<const T&, std::string_view>;
+
+        template <typename T>
+        struct IsKeyValue : std::false_type {};
+        template <typename T>
+        struct IsKeyValue<KeyValue<T>> : std::true_type {};
+
+        template <typename T>
+        concept LogPointer = std::is_same_v<T, void*> || std::is_same_v<T, const void*> || std::is_same_v<T, std::nullptr_t>;
+
+        template <typename T>
+        concept LogScalar = (std::is_floating_point_v<T> && !std::is_same_v<T, long double>) ||
+            (std::is_integral_v<T> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char8_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>);
+
+        // Types captured as raw bytes, everything else is formatted on the calling thread
+        template <typename T>
+        concept LogSerializableValue = LogScalar<T> || LogString<T> || LogPointer<T>;
+
+        template <typename T>
+        concept LogSerializable = LogSerializableValue<T> || (IsKeyValue<T>::value && LogSerializableValue<std::remove_cvref_t<decltype(std::declval<T>().value)>>);
+
+        class ArgWriter
+        {
+        public:
+            explicit ArgWriter(std::span<std::byte> buffer) noexcept : m_pos(buffer.data()), m_end(buffer.data() + buffer.size()) {}
+
+            bool put(ArgTag tag, const void* bytes, size_t size) noexcept
+            {
+                if (static_cast<size_t>(m_end - m_pos) < size + 1) return false;
+                *m_pos++ = static_cast<std::byte>(tag);
+                std::memcpy(m_pos, bytes, size);
+                m_pos += size;
+                return true;
+            }
+
+            bool putString(std::string_view str, ArgTag tag = ArgTag::String) noexcept
+            {
+                if (str.size() > UINT16_MAX) return false;
+                const auto length = static_cast<uint16_t>(str.size());
+                if (static_cast<size_t>(m_end - m_pos) < sizeof(length) + 1 + str.size()) return false;
+                *m_pos++ = static_cast<std::byte>(tag);
+                std::memcpy(m_pos, &length, sizeof(length));
+                m_pos += sizeof(length);
+                if (length) std::memcpy(m_pos, str.data(), length);
+                m_pos += length;
+                return true;
+            }
+
+            template <typename T>
+            bool write(const T& value) noexcept
+            {
+                using V = std::remove_cvref_t<T>;
+                if constexpr (IsKeyValue<V>::value) {
+                    return putString(value.key, ArgTag::Key) && write(value.value);
+                }
+                else if constexpr (LogPointer<V>) {
+                    const void* pointer = value;
+                    return put(ArgTag::Pointer, &pointer, sizeof(pointer));
+                }
+                else if constexpr (LogString<V>) {
+                    return putString(std::string_view(value));
+                }
+                else if constexpr (std::is_same_v<V, bool>) {
+                    return put(ArgTag::Bool, &value, 1);
+                }
+                else if constexpr (std::is_same_v<V, char>) {
+                    return put(ArgTag::Char, &value, 1);
+                }
+                else if constexpr (std::is_same_v<V, float>) {
+                    return put(ArgTag::Float, &value, sizeof(float));
+                }
+                else if constexpr (std::is_floating_point_v<V>) {
+                    const double widened = value;
+                    return put(ArgTag::Double, &widened, sizeof(widened));
+                }
+                else if constexpr (std::is_signed_v<V>) {
+                    const int64_t widened = value;
+                    return put(ArgTag::Int64, &widened, sizeof(widened));
+                }
+                else {
+                    const uint64_t widened = value;
+                    return put(ArgTag::UInt64, &widened, sizeof(widened));
+                }
+            }
+
+            size_t written(const std::byte* begin) const noexcept { return static_cast<size_t>(m_pos - begin); }
+
+        private:
+            std::byte* m_pos;
+            std::byte* m_end;
+        };
+    }
+
+    // Serialize args into record.payload. False when a type must be formatted eagerly or the
+    // arguments do not fit, the caller then falls back to SetRecordText
+    template <typename... Args>
+    bool EncodeArgs(LogRecord& record, const Args&... args) noexcept
+    {
+        if constexpr (!(details::LogSerializable<std::remove_cvref_t<Args>> && ...) || sizeof...(Args) > LogRecord::maxArgs) {
+            return false;
+        }
+        else {
+            details::ArgWriter writer(record.payload);
+            if (!(writer.write(args) && ...)) return false;
+            record.payloadSize = static_cast<uint16_t>(writer.written(record.payload.data()));
+            record.argCount = static_cast<uint8_t>(sizeof...(Args));
+            return true;
+        }
+    }
+
+    // Format on the calling thread, kv() fields are appended the way FormatPayload does it
+    template <typename... Args>
+    std::string FormatText(std::string_view format, const Args&... args)
+    {
+        std::string text = std::vformat(format, std::make_format_args(args...));
+        ([&] {
+            if constexpr (details::IsKeyValue<Args>::value) std::format_to(std::back_inserter(text), " {}={}", args.key, args.value);
+            }(), ...);
+        return text;
+    }
+
+    // Store an already formatted message, inline when it fits and on the heap otherwise
+    void SetRecordText(LogRecord& record, std::string text);
+
+    // Decode argCount arguments of a payload into out. Throws std::format_error on a malformed payload
+    size_t DecodeArgs(std::span<const std::byte> payload, size_t argCount, LogArg* out);
+
+    // Render format against a serialized payload, appending to out. kv() fields are appended as
+    // " key=value" unless withFields is false.
+    // Throws std::format_error on a malformed format string or payload
+    void FormatPayload(std::vector<char>& out, std::string_view format, std::span<const std::byte> payload, size_t argCount, bool withFields = true);
+
+    // Render the message of a record, its format and payload or its heap text
+    void FormatRecord(std::vector<char>& out, const LogRecord& record, bool withFields = true);
+}
+
+// Formats as the bare value, so kv() arguments also work in {} placeholders and eager formatting
+template <typename T>
+struct std::formatter<Debug::KeyValue<T>> : std::formatter<std::remove_cvref_t<T>>
+{
+    auto format(const Debug::KeyValue<T>& field, auto& ctx) const
+    {
+        return std::formatter<std::remove_cvref_t<T>>::format(field.value, ctx);
+    }
+};
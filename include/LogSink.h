@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Debug
+{
+    // Destination for formatted log text. The logger thread hands every sink the whole batch of a
+    // pass as a list of segments; write is only ever called from one thread at a time, flush may
+    // be called from any thread.
+    class LogSink
+    {
+    public:
+        virtual ~LogSink() = default;
+        virtual void write(std::span<const std::string_view> batch) = 0;
+        // Block until everything written so far has reached the destination
+        virtual void flush() {}
+        // Like flush, and also have the OS commit it to storage
+        virtual void sync() { flush(); }
+    };
+
+    // Writes each batch to a file descriptor with a single writev (a write loop on Windows)
+    class FdLogSink : public LogSink
+    {
+    public:
+        explicit FdLogSink(int fd) noexcept : m_fd(fd) {}
+        void write(std::span<const std::string_view> batch) override;
+        // fsync, a no-op on terminals and pipes
+        void sync() override;
+        uint64_t writeErrors() const noexcept { return m_writeErrors.load(std::memory_order_relaxed); }
+        int fd() const noexcept { return m_fd; }
+
+    protected:
+        int m_fd;
+        std::atomic_uint64_t m_writeErrors = 0;
+    };
+
+    class ConsoleLogSink : public FdLogSink
+    {
+    public:
+        enum class Stream { Out, Err };
+        explicit ConsoleLogSink(Stream stream = Stream::Out) noexcept;
+    };
+
+    class FileLogSink : public FdLogSink
+    {
+    public:
+        // Throws std::runtime_error when the file cannot be opened
+        explicit FileLogSink(const std::filesystem::path& path, bool append = true);
+        ~FileLogSink() override;
+        FileLogSink(const FileLogSink&) = delete;
+        FileLogSink& operator=(const FileLogSink&) = delete;
+    };
+
+    // File sink that starts a new segment once the active one would pass maxBytes or is older than
+    // maxAge. Rotated segments are renamed log.1.txt, log.2.txt, ... (newest first) and only
+    // maxFiles of them are kept. New segments are preallocated on disk, without changing their
+    // size, so appends do not hit extent allocation. Rotation runs inside write, on the logger
+    // thread (or the AsyncLogSink thread), never on producers.
+    class RotatingFileLogSink : public FdLogSink
+    {
+    public:
+        struct Options
+        {
+            std::filesystem::path path = "log.txt";
+            uint64_t maxBytes = 16 * 1024 * 1024;       // 0 disables size based rotation
+            std::chrono::seconds maxAge{ 0 };           // 0 disables time based rotation
+            uint32_t maxFiles = 4;
+            bool preallocate = true;                    // reserve maxBytes for every new segment
+        };
+
+        // Appends to an existing active file. Throws std::runtime_error when it cannot be opened
+        explicit RotatingFileLogSink(Options options);
+        ~RotatingFileLogSink() override;
+        RotatingFileLogSink(const RotatingFileLogSink&) = delete;
+        RotatingFileLogSink& operator=(const RotatingFileLogSink&) = delete;
+
+        void write(std::span<const std::string_view> batch) override;
+        // Start a new segment now, from the thread that calls write
+        void rotate();
+
+        const Options& options() const noexcept { return m_options; }
+        uint64_t segmentBytes() const noexcept { return m_segmentBytes; }
+        uint64_t rotations() const noexcept { return m_rotations; }
+        std::filesystem::path segmentPath(uint32_t index) const;
+
+    private:
+        Options m_options;
+        uint64_t m_segmentBytes = 0;
+        uint64_t m_rotations = 0;
+        std::chrono::steady_clock::time_point m_openedAt;
+
+        void open(bool append);
+        void close() noexcept;
+    };
+
+    // Keeps the most recent capacity bytes of log text in memory, readable from any thread
+    class RingLogSink : public LogSink
+    {
+    public:
+        explicit RingLogSink(size_t capacity);
+        void write(std::span<const std::string_view> batch) override;
+        // Retained text, oldest first
+        std::string contents() const;
+        void clear();
+
+    private:
+        std::vector<char> m_ring;
+        size_t m_head = 0;  // next write position
+        size_t m_size = 0;
+        mutable std::mutex m_mutex;
+    };
+
+    // RingLogSink kept in a memory-mapped file: the most recent capacity bytes of log text reach the
+    // page cache as they are written, so they survive the process crashing or being killed.
+    // MappedRingLogSink::read unrolls such a file into plain text
+    class MappedRingLogSink : public LogSink
+    {
+    public:
+        // Creates or truncates path. Throws std::runtime_error when it cannot be mapped
+        MappedRingLogSink(const std::filesystem::path& path, size_t capacity);
+        ~MappedRingLogSink() override;
+        MappedRingLogSink(const MappedRingLogSink&) = delete;
+        MappedRingLogSink& operator=(const MappedRingLogSink&) = delete;
+
+        void write(std::span<const std::string_view> batch) override;
+        // Ask the OS to write the mapping back, only needed to survive the machine going down
+        void flush() override;
+        // Same, and wait for it
+        void sync() override;
+
+        // Retained text of a ring file, oldest first. Throws std::runtime_error if it is not one
+        static std::string read(const std::filesystem::path& path);
+
+    private:
+        struct Header
+        {
+            char magic[8];
+            uint64_t capacity;
+            uint64_t head;      // next write position
+            uint64_t size;
+        };
+
+        Header* m_header = nullptr;
+        char* m_ring = nullptr;
+        size_t m_mappedBytes = 0;
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+
+    class NullLogSink : public LogSink
+    {
+    public:
+        void write(std::span<const std::string_view>) override {}
+    };
+
+    // Runs a slow sink on its own thread so it can never stall the logger or the other sinks.
+    // Batches are copied into a pending buffer and coalesced; past maxPendingBytes new text is
+    // dropped, counted and reported to the wrapped sink once it catches up
+    class AsyncLogSink : public LogSink
+    {
+    public:
+        explicit AsyncLogSink(std::shared_ptr<LogSink> sink, size_t maxPendingBytes = 4 * 1024 * 1024);
+        ~AsyncLogSink() override;
+        AsyncLogSink(const AsyncLogSink&) = delete;
+        AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+        void write(std::span<const std::string_view> batch) override;
+        void flush() override;
+        void sync() override;
+        uint64_t droppedBytes() const noexcept { return m_droppedBytes.load(std::memory_order_relaxed); }
+
+    private:
+        std::shared_ptr<LogSink> m_sink;
+        size_t m_maxPendingBytes;
+        std::vector<char> m_pending;
+        uint64_t m_pendingDrops = 0;
+        uint64_t m_queued = 0;      // batches accepted
+        uint64_t m_written = 0;     // batches handed to the wrapped sink
+        bool m_running = true;
+        std::atomic_uint64_t m_droppedBytes = 0;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::condition_variable m_flushedCv;
+        std::thread m_thread;
+
+        void run();
+        void waitWritten();
+    };
+}
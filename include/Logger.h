@@ -1,21 +1,123 @@
 ﻿#pragma once
 #include "Log.h"
+#include "LogRecord.h"
+#include "LogSink.h"
+#include "StringHash.h"
+#include "TimerStats.h"
+#include "TscClock.h"
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <filesystem>
 #include <future>
+#include <optional>
+#include <memory>
 #include <mutex>
 #include <ostream>
-#include <queue>
+#include <string>
 #include <thread>
-
-#include "FixedQueue.h"
+#include <unordered_map>
+#include <vector>
 
 
 namespace	Debug {
 
+    class BinaryLogWriter;
+    class Logger;
+
+    // Named subsystem log with its own level mask and sinks, registered with Logger::channel().
+    // A channel without sinks of its own writes to the logger's sinks, its messages tagged with
+    // its name. Each channel gets an int CVar "log.<name>" holding its verbosity, the lowest level
+    // it writes (0 trace ... 4 fatal error, exceptions and asserts are always written); the logger
+    // thread picks up changes to it a few times a second
+    class LogChannel
+    {
+    public:
+        LogChannel(const LogChannel&) = delete;
+        LogChannel& operator=(const LogChannel&) = delete;
+
+        std::string_view name() const noexcept { return m_name; }
+        uint8_t id() const noexcept { return m_id; }
+        // Checked before anything is captured or formatted, false once the logger is frozen
+        bool isEnabled(Log::Type type) const noexcept;
+        void setLogMask(Log::TypeFlags mask) noexcept { m_mask.store(mask.getMask(), std::memory_order_relaxed); }
+        Log::TypeFlags getLogMask() const noexcept { return Log::TypeFlags(m_mask.load(std::memory_order_relaxed)); }
+        // Sets the mask and the channel's CVar
+        void setVerbosity(int level);
+        // Sink changes are picked up by the logger thread on its next pass
+        void addSink(std::shared_ptr<LogSink> sink);
+        void removeSink(const std::shared_ptr<LogSink>& sink);
+        void clearSinks();
+
+    private:
+        friend class Logger;
+        LogChannel(Logger& logger, std::string name, uint8_t id);
+
+        Logger& m_logger;
+        std::string m_name;
+        std::string m_cvarName;
+        utl::StringHash m_cvar;
+        uint8_t m_id;
+        std::atomic<Log::TypeFlags::MaskType> m_mask;
+        std::atomic_int64_t m_verbosity;    // CVar value last applied by the channel itself
+        std::mutex m_sinkMutex;
+        std::vector<std::shared_ptr<LogSink>> m_sinks;
+    };
+
+    // Log mask that keeps level (0 trace ... 4 fatal error) and everything above it
+    Log::TypeFlags VerbosityMask(int level) noexcept;
+
     //How many logs could a logger log if a logger could log logs
+    //Every producing thread owns a lock-free SPSC buffer that the logger thread drains, so
+    //logging never takes a lock once the thread is registered. Arguments are serialized into
+    //fixed-size records stamped with TscClock ticks, and only formatted (and converted to wall
+    //clock time) on the logger thread. A full buffer applies the
+    //configured Backpressure policy; drops are counted and reported in-band. Each call site is
+    //rate limited before anything is captured. Each pass is formatted once and handed to every
+    //sink as one batch; by default an async console sink and "log.txt".
     class Logger
     {
     public:
+        static constexpr size_t threadBufferCapacity = 1024;
+        // Spilled records kept per thread before Spill falls back to dropping, severe types always spill
+        static constexpr size_t maxSpillRecords = 64 * 1024;
+        // Buffers of exited threads the flight recorder keeps
+        static constexpr size_t keptRetiredBuffers = 4;
+        static constexpr size_t maxChannels = 255;
+
+        // What a producer does when its thread buffer is full
+        enum class Backpressure : uint8_t
+        {
+            Block,      // wait for the logger thread to make room
+            DropNewest, // discard the new log
+            DropOldest, // evict the oldest queued log, or the new one while the logger is reading it
+            Spill       // append to a per-thread overflow list, written in order after the buffer
+        };
+
+        // How far flush() takes the logs pushed before it
+        enum class FlushLevel : uint8_t
+        {
+            Written,    // handed to every sink and flushed by them
+            Synced      // also committed to storage by the sinks (fsync)
+        };
+
+        // Layout of the text handed to sinks, a binary log replaces either
+        enum class OutputFormat : uint8_t
+        {
+            Text,
+            JsonLines   // one JSON object per log, kv() fields as typed members (see JsonLog.h)
+        };
+
+        // Token bucket per call site, checked on the producer before anything is captured: a site
+        // may log burst messages at once and perSecond after that. The rest cost one atomic add and
+        // are reported as "repeated N times" by the logger thread. Off by default, burst 0 disables
+        // the limit. Errors, fatal errors, exceptions and asserts are never limited
+        struct RateLimit
+        {
+            uint32_t burst = 0;
+            uint32_t perSecond = 64;
+        };
+
         Logger(const Logger&) = delete;
         Logger(Logger&&) = delete;
         Logger& operator=(const Logger&) = delete;
@@ -29,29 +131,173 @@ namespace	Debug {
 
 
         bool isEmpty();
-        void addLog(const Log& log);
-        void dump();
-        void flush();
+        // Capture a log whose format string has static storage duration, formatting is deferred
+        template <typename... Args>
+        bool log(Log::Type type, const char* format, const std::source_location& source, const Args&... args);
+        template <typename... Args>
+        bool log(const LogChannel& channel, Log::Type type, const char* format, const std::source_location& source, const Args&... args);
+        // Registered on first use, the name is only needed then. Throws std::invalid_argument for an
+        // unknown channel without a name and std::runtime_error past maxChannels
+        LogChannel& channel(utl::StringHash name);
+        // Queue an already formatted log
+        bool addLog(const Log& log);
+        bool addLog(Log&& log);
+        // Flight recorder: thread buffers keep their last threadBufferCapacity records after they are
+        // written. dumpFlightRecorder writes them, queued or not, and the records still waiting in
+        // Spill lists as a binary log ordered by time across threads. It is async-signal-safe (see
+        // InstallCrashHandlers in FlightRecorder.h); records of a thread that logs during the dump
+        // may come out torn
+        bool dumpFlightRecorder(int fd) noexcept;
+        // Same, to a file. Throws std::runtime_error when it cannot be written
+        void dump(const std::filesystem::path& path);
+        // Block until every log pushed before the call is written. Each thread buffer counts the
+        // records committed to it and the logger thread publishes how many of them it has written
+        // after every pass; flush waits on that, sleeping (atomic wait) rather than spinning
+        void flush(FlushLevel level = FlushLevel::Written);
+        // Latency of the flush() calls so far
+        utl::TimerStats flushStats() const;
         void waitForReady();
         void waitForReady() const;
         void setLogMask(Log::TypeFlags mask);
+        Log::TypeFlags getLogMask() const noexcept { return Log::TypeFlags(logMask.load(std::memory_order_relaxed)); }
+        // Checked before anything is captured or formatted
+        bool isEnabled(Log::Type type) const noexcept
+        {
+            return !isFrozen() && (logMask.load(std::memory_order_relaxed) & static_cast<Log::TypeFlags::MaskType>(type)) != 0;
+        }
+        // For crash handlers: refuse every record from now on, on every channel, so
+        // dumpFlightRecorder reads buffers nobody writes to. A record that was already being
+        // written when freeze was called may still come out torn. Cannot be undone
+        void freeze() noexcept { frozen.store(true, std::memory_order_release); }
+        bool isFrozen() const noexcept { return frozen.load(std::memory_order_relaxed); }
+        uint64_t droppedCount() const noexcept;
+        // Errors, fatal errors, exceptions and asserts are never dropped: a drop policy on them
+        // behaves like Spill
+        void setBackpressure(Backpressure policy);
+        void setBackpressure(Log::TypeFlags types, Backpressure policy);
+        Backpressure getBackpressure(Log::Type type) const noexcept;
+        void setRateLimit(RateLimit limit);
+        RateLimit getRateLimit() const noexcept;
+        // Logs suppressed by the rate limit so far
+        uint64_t suppressedCount() const noexcept;
+        // Sink changes are picked up by the logger thread on its next pass
+        void addSink(std::shared_ptr<LogSink> sink);
+        void removeSink(const std::shared_ptr<LogSink>& sink);
+        void clearSinks();
+        // Write records to a compact binary log instead of text, decode it with myutils-logdecode.
+        // An empty path switches back to text. Applied by the logger thread on its next pass
+        void setBinaryLog(std::filesystem::path path);
+        // Applied by the logger thread on its next pass
+        void setOutputFormat(OutputFormat format) noexcept { outputFormat.store(format, std::memory_order_relaxed); }
+        OutputFormat getOutputFormat() const noexcept { return outputFormat.load(std::memory_order_relaxed); }
     private:
-        Log::TypeFlags logMask;
+        friend class LogChannel;
+        struct ThreadBuffer;
+        struct ThreadBufferHandle
+        {
+            std::shared_ptr<ThreadBuffer> buffer;
+            ~ThreadBufferHandle();
+        };
+        static thread_local ThreadBufferHandle localHandle;
+
+        std::atomic<Log::TypeFlags::MaskType> logMask;
+        std::atomic_bool frozen = false;
         std::thread thread;
         std::atomic_bool running = true;
+        std::atomic_bool sleeping = false;
+        bool wakeRequested = false;
         std::mutex mtx;
-        utl::FixedQueue<Log,1024> messageQueue;
-        utl::FixedQueue<Log,1024> tempQueue;
         std::condition_variable cv;
-        std::atomic_size_t pendingMessages = 0;
+        std::atomic_uint32_t passesWritten = 0; // bumped and notified once a pass reached the sinks
+        mutable std::mutex flushStatsMtx;
+        utl::TimerStats flushTimes;
+        std::atomic_uint64_t droppedTotal = 0;
+        std::array<std::atomic<Backpressure>, 7> backpressure;
+        struct CallSites;
+        std::unique_ptr<CallSites> callSites;
+        std::atomic_uint32_t rateBurst;
+        std::atomic_uint32_t ratePerSecond;
+        std::atomic_bool suppressedPending = false;
+        // Last clock calibration of the logger thread for dumps, a seqlock so a reader never mixes two
+        std::atomic_uint32_t clockSeq = 0;
+        std::atomic_uint64_t clockAnchorTicks = 0;
+        std::atomic_int64_t clockAnchorNanos = 0;
+        std::atomic<double> clockNanosPerTick = 1.0;
+        std::atomic<OutputFormat> outputFormat = OutputFormat::Text;
+        std::atomic_bool binaryLogChanged = false;
+        std::optional<std::filesystem::path> pendingBinaryLog;
+        std::unique_ptr<BinaryLogWriter> binaryLog;
+        std::mutex sinkMtx;
+        std::vector<std::shared_ptr<LogSink>> sinks;
+        std::atomic_bool sinksChanged = true;
+        std::mutex channelMtx;
+        std::vector<std::unique_ptr<LogChannel>> channels;   // id - 1
+        std::unordered_map<uint64_t, LogChannel*> channelIndex;
+        std::atomic_bool channelsChanged = false;
+        std::mutex registryMtx;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::vector<std::shared_ptr<ThreadBuffer>> retiredBuffers;  // last few of exited threads, for dumps
         std::promise<void> readyPromise;
         std::shared_future<void> readyFuture;
 
         Logger();
         ~Logger();
 
+        template <typename... Args>
+        bool capture(uint8_t channel, Log::Type type, const char* format, const std::source_location& source, const Args&... args);
+        ThreadBuffer& localBuffer();
+        LogRecord* reserveRecord(Log::Type type);
+        LogRecord* reserveFull(ThreadBuffer& threadBuffer, Log::Type type);
+        void commitRecord();
+        void publishClock(const utl::TscConversion& conversion) noexcept;
+        utl::TscConversion readClock() const noexcept;
+        bool admit(Log::Type type, const std::source_location& source);
+        void reportSuppressed(std::vector<char>& buffer, int64_t timestamp, bool json);
+        void wake();
         void runAsync();
     };
+
+    inline bool LogChannel::isEnabled(Log::Type type) const noexcept
+    {
+        return !m_logger.isFrozen() && (m_mask.load(std::memory_order_relaxed) & static_cast<Log::TypeFlags::MaskType>(type)) != 0;
+    }
+
+    template <typename... Args>
+    bool Logger::log(Log::Type type, const char* format, const std::source_location& source, const Args&... args)
+    {
+        return isEnabled(type) && capture(0, type, format, source, args...);
+    }
+
+    template <typename... Args>
+    bool Logger::log(const LogChannel& channel, Log::Type type, const char* format, const std::source_location& source, const Args&... args)
+    {
+        return channel.isEnabled(type) && capture(channel.id(), type, format, source, args...);
+    }
+
+    template <typename... Args>
+    bool Logger::capture(uint8_t channel, Log::Type type, const char* format, const std::source_location& source, const Args&... args)
+    {
+        if (!admit(type, source)) return false;
+        LogRecord* record = reserveRecord(type);
+        if (!record) return false;
+        record->format = format;
+        record->channel = channel;
+        record->source = source;
+        record->type = type;
+        record->timestamp = utl::TscClock::ticks();
+        if (!EncodeArgs(*record, args...)) {
+            SetRecordText(*record, FormatText(format, args...));
+        }
+        commitRecord();
+        return true;
+    }
+
     void PrintOut(Debug::Log& log, std::ostream& stream);
+    // Text layout shared by the logger thread and the binary log decoder. A continuation
+    // (same call site as the previous message) only gets the "|> " marker. Every message starts
+    // with its UTC time of day to the microsecond, timestamp is system_clock ns since the epoch
+    void FormatLogPrefix(std::vector<char>& out, Log::Type type, std::string_view file, uint32_t line, uint32_t column, bool continuation, int64_t timestamp);
+    void FormatDropNotice(std::vector<char>& out, uint64_t count, uint32_t threadIndex);
+    void FormatSuppressedNotice(std::vector<char>& out, Log::Type type, std::string_view file, uint32_t line, uint32_t column, uint64_t count, int64_t timestamp);
     constexpr std::string_view StreamLogType(Debug::Log::Type type) noexcept;
 };
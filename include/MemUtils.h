@@ -1,5 +1,10 @@
 ﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
 
+#include "BitFlags.h"
 
 //bytes to kilobytes
 constexpr size_t B_TO_KB = 1024ll;
@@ -8,11 +13,12 @@ constexpr size_t B_TO_MB = 1024ll * 1024;
 //bytes to gigabytes
 constexpr size_t B_TO_GB = 1024ll * 1024 * 1024;
 
-constexpr size_t KB_TO_B = 1 / B_TO_KB;
+//inverse factors, these are fractions so they must not be integers
+constexpr double KB_TO_B = 1.0 / B_TO_KB;
 
-constexpr size_t MB_TO_B = 1 / B_TO_MB;
+constexpr double MB_TO_B = 1.0 / B_TO_MB;
 
-constexpr size_t GB_TO_B = 1 / B_TO_GB;
+constexpr double GB_TO_B = 1.0 / B_TO_GB;
 
 
 
@@ -36,3 +42,85 @@ constexpr size_t GbToBytes(const size_t gb) { return gb * B_TO_GB; }
 constexpr size_t GbToKb(const size_t gb) { return gb * B_TO_MB; }
 constexpr size_t GbToMb(const size_t gb) { return gb * B_TO_KB; }
 
+
+namespace utl {
+
+    inline constexpr size_t cacheLineSize = 64;
+
+    // OS page size and the default (transparent) huge page size, 0 if huge pages are unknown
+    size_t PageSize() noexcept;
+    size_t HugePageSize() noexcept;
+
+    constexpr size_t AlignUp(const size_t value, const size_t alignment) noexcept { return (value + alignment - 1) & ~(alignment - 1); }
+
+    // Aligned heap allocation, release with AlignedFree. Throws std::bad_alloc on failure
+    [[nodiscard]] void* AlignedAlloc(size_t bytes, size_t alignment);
+    void AlignedFree(void* ptr) noexcept;
+    [[nodiscard]] inline void* CacheAlignedAlloc(const size_t bytes) { return AlignedAlloc(bytes, cacheLineSize); }
+    [[nodiscard]] inline void* PageAlignedAlloc(const size_t bytes) { return AlignedAlloc(bytes, PageSize()); }
+
+
+    enum class MapFlagBits : uint8_t {
+        none = 0,
+        populate = 1 << 0,         // fault every page in up front (MAP_POPULATE)
+        hugePages = 1 << 1,        // ask for transparent huge pages (MADV_HUGEPAGE), region is huge page aligned
+        explicitHugePages = 1 << 2, // reserved huge pages (MAP_HUGETLB / MEM_LARGE_PAGES), falls back to hugePages
+    };
+    using MapFlags = utl::BitFlags<MapFlagBits>;
+
+    // Size MapRegion actually maps for a request: rounded up to the page, or huge page, size
+    size_t MapRegionSize(size_t bytes, MapFlags flags = {}) noexcept;
+    // Anonymous virtual memory straight from the OS, zero filled. Returns nullptr on failure.
+    // Release with UnmapRegion using the same bytes and flags
+    [[nodiscard]] void* MapRegion(size_t bytes, MapFlags flags = {}) noexcept;
+    void UnmapRegion(void* ptr, size_t bytes, MapFlags flags = {}) noexcept;
+    // Hint the kernel to back the range with huge pages
+    bool AdviseHugePages(void* ptr, size_t bytes) noexcept;
+    // Drop the physical pages behind the range but keep the mapping, next touch reads zeros (MADV_DONTNEED)
+    bool AdviseDontNeed(void* ptr, size_t bytes) noexcept;
+
+
+    // Owning, move-only mapped region for large lookup tables, huge page backed by default
+    class HugeBuffer {
+    public:
+        HugeBuffer() noexcept = default;
+        explicit HugeBuffer(size_t bytes, MapFlags flags = MapFlagBits::hugePages);
+        ~HugeBuffer() { reset(); }
+
+        HugeBuffer(const HugeBuffer&) = delete;
+        HugeBuffer& operator=(const HugeBuffer&) = delete;
+        HugeBuffer(HugeBuffer&& other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)),
+            m_mappedSize(std::exchange(other.m_mappedSize, 0)), m_flags(other.m_flags) {
+        }
+        HugeBuffer& operator=(HugeBuffer&& other) noexcept {
+            if (this != &other) {
+                reset();
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_mappedSize = std::exchange(other.m_mappedSize, 0);
+                m_flags = other.m_flags;
+            }
+            return *this;
+        }
+
+        void reset() noexcept;
+        // Give the physical memory back while keeping the buffer mapped (contents become zero)
+        void discard() noexcept;
+
+        std::byte* data() const noexcept { return m_data; }
+        size_t size() const noexcept { return m_size; }
+        size_t mappedSize() const noexcept { return m_mappedSize; }
+        std::span<std::byte> bytes() const noexcept { return { m_data, m_size }; }
+        explicit operator bool() const noexcept { return m_data != nullptr; }
+
+        template <typename T>
+        std::span<T> as() const noexcept { return { reinterpret_cast<T*>(m_data), m_size / sizeof(T) }; }
+
+    private:
+        std::byte* m_data{ nullptr };
+        size_t m_size{ 0 };
+        size_t m_mappedSize{ 0 };
+        MapFlags m_flags{};
+    };
+}
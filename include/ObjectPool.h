@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace utl {
+
+    namespace details {
+        template <typename T>
+        concept Clearable = requires(T & obj) { obj.clear(); };
+
+        // clear() when available (keeps string/vector capacity), otherwise assign a fresh T
+        template <typename T>
+        struct DefaultPoolReset {
+            void operator()(T& obj) const {
+                if constexpr (Clearable<T>) obj.clear();
+                else obj = T{};
+            }
+        };
+    }
+
+    // Pool of constructed objects that are reset and recycled instead of destroyed, so objects
+    // owning buffers keep their capacity warm. Objects are rented through RAII handles and
+    // returned when the handle dies; at most maxRetained idle objects are kept.
+    // The pool must outlive every handle rented from it. An object whose reset throws is destroyed
+    // instead of being retained, so returning an object never throws.
+    template <typename T, typename Reset = details::DefaultPoolReset<T>>
+        requires std::is_default_constructible_v<T> && std::invocable<Reset&, T&>
+    class ObjectPool {
+    public:
+        class Handle {
+        public:
+            Handle() noexcept = default;
+            ~Handle() { reset(); }
+
+            Handle(const Handle&) = delete;
+            Handle& operator=(const Handle&) = delete;
+            Handle(Handle&& other) noexcept : m_pool(std::exchange(other.m_pool, nullptr)), m_object(std::move(other.m_object)) {}
+            Handle& operator=(Handle&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_pool = std::exchange(other.m_pool, nullptr);
+                    m_object = std::move(other.m_object);
+                }
+                return *this;
+            }
+
+            // Give the object back to the pool early
+            void reset() noexcept {
+                if (m_object) m_pool->giveBack(std::move(m_object));
+                m_pool = nullptr;
+            }
+
+            // Take the object out of the pool's care entirely
+            std::unique_ptr<T> detach() noexcept {
+                m_pool = nullptr;
+                return std::move(m_object);
+            }
+
+            T* get() const noexcept { return m_object.get(); }
+            T& operator*() const noexcept { return *m_object; }
+            T* operator->() const noexcept { return m_object.get(); }
+            explicit operator bool() const noexcept { return m_object != nullptr; }
+
+        private:
+            friend class ObjectPool;
+            Handle(ObjectPool* pool, std::unique_ptr<T> object) noexcept : m_pool(pool), m_object(std::move(object)) {}
+
+            ObjectPool* m_pool{ nullptr };
+            std::unique_ptr<T> m_object{};
+        };
+
+        explicit ObjectPool(size_t maxRetained = 64, Reset reset = {})
+            : m_reset(std::move(reset)), m_maxRetained(maxRetained) {
+        }
+
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool(ObjectPool&&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+        ObjectPool& operator=(ObjectPool&&) = delete;
+
+        // Reuse an idle object, or construct a new one when none are retained
+        [[nodiscard]] Handle rent() {
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_idle.empty()) {
+                    auto object = std::move(m_idle.back());
+                    m_idle.pop_back();
+                    return Handle(this, std::move(object));
+                }
+            }
+            return Handle(this, std::make_unique<T>());
+        }
+
+        // Pre-construct idle objects up to count (bounded by maxRetained)
+        void reserve(size_t count) {
+            std::lock_guard lock(m_mutex);
+            count = std::min(count, m_maxRetained);
+            m_idle.reserve(count);
+            while (m_idle.size() < count) {
+                m_idle.push_back(std::make_unique<T>());
+            }
+        }
+
+        void setMaxRetained(size_t maxRetained) {
+            std::lock_guard lock(m_mutex);
+            m_maxRetained = maxRetained;
+            if (m_idle.size() > m_maxRetained) m_idle.resize(m_maxRetained);
+        }
+
+        // Destroy every idle object
+        void clear() {
+            std::lock_guard lock(m_mutex);
+            m_idle.clear();
+        }
+
+        size_t idleCount() const {
+            std::lock_guard lock(m_mutex);
+            return m_idle.size();
+        }
+        size_t maxRetained() const {
+            std::lock_guard lock(m_mutex);
+            return m_maxRetained;
+        }
+
+    private:
+        Reset m_reset;
+        size_t m_maxRetained;
+        std::vector<std::unique_ptr<T>> m_idle{};
+        mutable std::mutex m_mutex{};
+
+        // Runs from ~Handle, a half reset object is not worth keeping: drop it on any exception
+        void giveBack(std::unique_ptr<T> object) noexcept {
+            try {
+                m_reset(*object);
+                std::lock_guard lock(m_mutex);
+                if (m_idle.size() < m_maxRetained) {
+                    m_idle.push_back(std::move(object));
+                }
+            }
+            catch (...) {
+            }
+        }
+    };
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace utl {
+
+    // Size-class slab allocator for small, high-churn objects.
+    // Requests up to maxSmallSize are rounded to a size class (16 byte steps up to 128, then four
+    // steps per power of two) and served from a thread-local stack of free pointers. Thread caches
+    // refill from and spill to a per-class central stack a batch at a time, copying pointers without
+    // touching the objects; slabs are carved from slabSize blocks that are kept for the lifetime of
+    // the process. Larger or over-aligned requests go to ::operator new.
+    // Memory may be freed on any thread, but the size passed to deallocate must match the allocation.
+    class SlabAllocator {
+    public:
+        static constexpr size_t maxSmallSize = 1024;
+        static constexpr size_t slabSize = 64 * 1024;
+        static constexpr size_t classCount = 21;
+
+        [[nodiscard]] static void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+        static void deallocate(void* ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) noexcept;
+
+        // Size class index for a request, or classCount when it is not served from slabs
+        static constexpr size_t sizeClass(size_t bytes) noexcept {
+            if (bytes <= 8) return 0;
+            if (bytes <= 128) return (bytes + 15) / 16; // 16..128 -> 1..8
+            if (bytes > maxSmallSize) return classCount;
+            // Four classes per power of two: 160, 192, 224, 256, 320, ...
+            const size_t shift = std::bit_width(bytes - 1) - 3;
+            const size_t step = (bytes - 1) >> shift;        // 4..7
+            return 9 + (shift - 5) * 4 + (step - 4);
+        }
+
+        static constexpr size_t classSize(size_t index) noexcept {
+            if (index == 0) return 8;
+            if (index <= 8) return index * 16;
+            const size_t shift = (index - 9) / 4 + 5;
+            const size_t step = (index - 9) % 4 + 5;
+            return step << shift;
+        }
+
+        struct Stats {
+            size_t slabBytes{ 0 };        // bytes reserved for slabs
+            size_t largeAllocations{ 0 }; // requests that bypassed the slabs
+        };
+        static Stats stats() noexcept;
+
+        // Shared memory_resource over the slab allocator
+        static std::pmr::memory_resource* resource() noexcept;
+    };
+
+    static_assert(SlabAllocator::classSize(SlabAllocator::classCount - 1) == SlabAllocator::maxSmallSize);
+    static_assert(SlabAllocator::sizeClass(SlabAllocator::maxSmallSize) == SlabAllocator::classCount - 1);
+
+
+    // memory_resource wrapper, use SlabAllocator::resource() for the shared instance
+    class SlabResource final : public std::pmr::memory_resource {
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override { return SlabAllocator::allocate(bytes, alignment); }
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override { SlabAllocator::deallocate(ptr, bytes, alignment); }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return dynamic_cast<const SlabResource*>(&other) != nullptr;
+        }
+    };
+
+
+    // STL allocator over the slab allocator, e.g. std::vector<int, StlSlabAllocator<int>>
+    template <typename T>
+    struct StlSlabAllocator {
+        using value_type = T;
+
+        StlSlabAllocator() noexcept = default;
+        template <typename U>
+        StlSlabAllocator(const StlSlabAllocator<U>&) noexcept {}
+
+        [[nodiscard]] T* allocate(size_t count) {
+            return static_cast<T*>(SlabAllocator::allocate(sizeof(T) * count, alignof(T)));
+        }
+        void deallocate(T* ptr, size_t count) noexcept {
+            SlabAllocator::deallocate(ptr, sizeof(T) * count, alignof(T));
+        }
+
+        template <typename U>
+        bool operator==(const StlSlabAllocator<U>&) const noexcept { return true; }
+    };
+
+}
@@ -1,7 +1,16 @@
 ﻿#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
 
 namespace utl {
 
+	template <typename T>
+	class StridedSlice;
+
 	template <typename T>
 	class Slice
 	{
@@ -15,9 +24,12 @@ namespace utl {
 		T* end() { return data + size; }
 		const T* end() const { return data + size; }
 		size_t getSize() const { return size; }
+		T* getData() const { return data; }
+		bool isEmpty() const { return size == 0; }
 
 		// Constructor to initialize the slice
 		Slice(T* data = nullptr, size_t size = 0) : data(data), size(size) {}
+		Slice(std::span<T> span) : data(span.data()), size(span.size()) {}
 
 		std::span<T> getSpan() const { return { data, size }; }
 
@@ -25,6 +37,175 @@ namespace utl {
 		T& operator[](size_t index) { return data[index]; }
 		auto&& operator[](size_t index) const { return data[index]; }
 
+		// Views into this slice, no copies. Out of range requests are clamped
+		Slice subslice(size_t offset, size_t count = SIZE_MAX) const
+		{
+			offset = std::min(offset, size);
+			return { data + offset, std::min(count, size - offset) };
+		}
+		Slice first(size_t count) const { return subslice(0, count); }
+		Slice last(size_t count) const { return subslice(size - std::min(count, size)); }
+
+		// Every stride-th element starting at offset, e.g. one channel of interleaved data
+		StridedSlice<T> strided(size_t stride, size_t offset = 0) const;
+
 
+		// Head/body/tail split for SIMD loops: head runs up to the first Alignment-byte boundary,
+		// body is the largest run of whole Width-element blocks after it, tail is the rest
+		struct AlignedSplit
+		{
+			Slice head;
+			Slice body;
+			Slice tail;
+		};
+
+		template <size_t Alignment = 32, size_t Width = std::max<size_t>(Alignment / sizeof(T), 1)>
+		AlignedSplit splitAligned() const
+		{
+			static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+			const auto address = reinterpret_cast<uintptr_t>(data);
+			size_t headCount = 0;
+			if (address % Alignment != 0) {
+				const size_t bytesToBoundary = Alignment - address % Alignment;
+				// Elements of T never line up with the boundary when sizeof(T) does not divide the gap
+				headCount = bytesToBoundary % sizeof(T) == 0 ? bytesToBoundary / sizeof(T) : size;
+			}
+			headCount = std::min(headCount, size);
+			const size_t bodyCount = (size - headCount) / Width * Width;
+			return { { data, headCount }, { data + headCount, bodyCount }, { data + headCount + bodyCount, size - headCount - bodyCount } };
+		}
+
+		// Walk the slice in Width-element blocks: block(std::span<T, Width>) for every whole block and
+		// scalar(T&) for the elements around them. With Alignment != 0 every block starts on an
+		// Alignment-byte boundary, otherwise blocks start at the first element
+		template <size_t Width, size_t Alignment = 0, typename BlockFn, typename ScalarFn>
+		void forEachChunk(BlockFn&& block, ScalarFn&& scalar) const
+		{
+			static_assert(Width > 0, "Width must be positive");
+			Slice head{ data, 0 };
+			Slice body{ data, size / Width * Width };
+			Slice tail{ data + body.size, size - body.size };
+			if constexpr (Alignment != 0) {
+				auto split = splitAligned<Alignment, Width>();
+				head = split.head;
+				body = split.body;
+				tail = split.tail;
+			}
+			for (auto& value : head) scalar(value);
+			for (size_t i = 0; i < body.size; i += Width) {
+				block(std::span<T, Width>(body.data + i, Width));
+			}
+			for (auto& value : tail) scalar(value);
+		}
 	};
+
+
+	// Non-owning view of every stride-th element. Strides are in elements
+	template <typename T>
+	class StridedSlice
+	{
+	private:
+		T* data;
+		size_t size;
+		size_t stride;
+	public:
+		class Iterator
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = std::remove_cv_t<T>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T*;
+			using reference = T&;
+
+			Iterator() = default;
+			Iterator(T* data, size_t index, size_t stride) : data(data), index(static_cast<difference_type>(index)), stride(static_cast<difference_type>(stride)) {}
+
+			T& operator*() const { return data[index * stride]; }
+			T* operator->() const { return data + index * stride; }
+			T& operator[](difference_type n) const { return data[(index + n) * stride]; }
+
+			Iterator& operator++() { ++index; return *this; }
+			Iterator operator++(int) { Iterator it = *this; ++index; return it; }
+			Iterator& operator--() { --index; return *this; }
+			Iterator operator--(int) { Iterator it = *this; --index; return it; }
+			Iterator& operator+=(difference_type n) { index += n; return *this; }
+			Iterator& operator-=(difference_type n) { index -= n; return *this; }
+			friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+			friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+			friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+			friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) { return lhs.index - rhs.index; }
+			friend bool operator==(const Iterator& lhs, const Iterator& rhs) { return lhs.index == rhs.index; }
+			friend auto operator<=>(const Iterator& lhs, const Iterator& rhs) { return lhs.index <=> rhs.index; }
+
+		private:
+			// Index based: data + size * stride may point past the underlying array
+			T* data{ nullptr };
+			difference_type index{ 0 };
+			difference_type stride{ 1 };
+		};
+
+		StridedSlice(T* data = nullptr, size_t size = 0, size_t stride = 1) : data(data), size(size), stride(stride) {}
+
+		Iterator begin() const { return { data, 0, stride }; }
+		Iterator end() const { return { data, size, stride }; }
+		size_t getSize() const { return size; }
+		size_t getStride() const { return stride; }
+		T* getData() const { return data; }
+		bool isEmpty() const { return size == 0; }
+		bool isContiguous() const { return stride == 1; }
+
+		T& operator[](size_t index) const { return data[index * stride]; }
+
+		StridedSlice subslice(size_t offset, size_t count = SIZE_MAX) const
+		{
+			if (offset >= size) return { data, 0, stride };
+			return { data + offset * stride, std::min(count, size - offset), stride };
+		}
+
+		// Slice of a slice: every step-th element of this view
+		StridedSlice strided(size_t step, size_t offset = 0) const
+		{
+			if (offset >= size || step == 0) return { data, 0, stride };
+			return { data + offset * stride, (size - offset + step - 1) / step, stride * step };
+		}
+
+		// Copy elements into contiguous scratch (and back) so the hot loop can run on dense data
+		size_t gather(std::span<std::remove_const_t<T>> out, size_t offset = 0) const
+		{
+			const size_t count = std::min(out.size(), size - std::min(offset, size));
+			for (size_t i = 0; i < count; ++i) out[i] = data[(offset + i) * stride];
+			return count;
+		}
+		size_t scatter(std::span<const std::remove_const_t<T>> in, size_t offset = 0) const
+		{
+			const size_t count = std::min(in.size(), size - std::min(offset, size));
+			for (size_t i = 0; i < count; ++i) data[(offset + i) * stride] = in[i];
+			return count;
+		}
+
+		// Gather Width elements at a time into a dense block for block(std::span<value_type, Width>),
+		// write them back afterwards, and hand the remainder to scalar(T&)
+		template <size_t Width, typename BlockFn, typename ScalarFn>
+		void forEachChunk(BlockFn&& block, ScalarFn&& scalar) const
+		{
+			static_assert(Width > 0, "Width must be positive");
+			std::array<std::remove_const_t<T>, Width> scratch;
+			const size_t whole = size / Width * Width;
+			for (size_t i = 0; i < whole; i += Width) {
+				gather(scratch, i);
+				block(std::span<std::remove_const_t<T>, Width>(scratch));
+				if constexpr (!std::is_const_v<T>) scatter(scratch, i);
+			}
+			for (size_t i = whole; i < size; ++i) scalar(data[i * stride]);
+		}
+	};
+
+
+	template <typename T>
+	StridedSlice<T> Slice<T>::strided(size_t stride, size_t offset) const
+	{
+		if (offset >= size || stride == 0) return { data, 0, 1 };
+		return { data + offset, (size - offset + stride - 1) / stride, stride };
+	}
 }
\ No newline at end of file
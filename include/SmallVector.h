@@ -0,0 +1,329 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+    // Vector with room for N elements inside the object, only touching the heap once it grows past N.
+    // Trivially copyable element types are relocated with memcpy when spilling or moving.
+    // Iterators and references are invalidated by growth and by moving an inline vector.
+    template <typename T, size_t N = 8>
+        requires (N > 0)
+    class SmallVector {
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        static constexpr size_t inlineCapacity = N;
+
+        SmallVector() noexcept = default;
+
+        explicit SmallVector(size_t count) {
+            resize(count);
+        }
+
+        SmallVector(size_t count, const T& value) {
+            resize(count, value);
+        }
+
+        SmallVector(std::initializer_list<T> init) {
+            assign(init.begin(), init.end());
+        }
+
+        template <std::input_iterator It>
+        SmallVector(It first, It last) {
+            assign(first, last);
+        }
+
+        SmallVector(const SmallVector& other) {
+            assign(other.begin(), other.end());
+        }
+
+        SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+            takeFrom(std::move(other));
+        }
+
+        ~SmallVector() {
+            destroyAll();
+            freeHeap();
+        }
+
+        SmallVector& operator=(const SmallVector& other) {
+            if (this != &other) assign(other.begin(), other.end());
+            return *this;
+        }
+
+        SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+            if (this != &other) {
+                destroyAll();
+                freeHeap();
+                m_data = inlineData();
+                m_capacity = N;
+                takeFrom(std::move(other));
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(std::initializer_list<T> init) {
+            assign(init.begin(), init.end());
+            return *this;
+        }
+
+        template <std::input_iterator It>
+        void assign(It first, It last) {
+            clear();
+            if constexpr (std::forward_iterator<It>) {
+                reserve(static_cast<size_t>(std::distance(first, last)));
+            }
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        }
+
+        // Element access
+        T& operator[](size_t index) noexcept { return m_data[index]; }
+        const T& operator[](size_t index) const noexcept { return m_data[index]; }
+        T& at(size_t index) {
+            if (index >= m_size) throw std::out_of_range("SmallVector::at");
+            return m_data[index];
+        }
+        const T& at(size_t index) const {
+            if (index >= m_size) throw std::out_of_range("SmallVector::at");
+            return m_data[index];
+        }
+        T& front() noexcept { return m_data[0]; }
+        const T& front() const noexcept { return m_data[0]; }
+        T& back() noexcept { return m_data[m_size - 1]; }
+        const T& back() const noexcept { return m_data[m_size - 1]; }
+        T* data() noexcept { return m_data; }
+        const T* data() const noexcept { return m_data; }
+
+        // Iterators
+        iterator begin() noexcept { return m_data; }
+        const_iterator begin() const noexcept { return m_data; }
+        const_iterator cbegin() const noexcept { return m_data; }
+        iterator end() noexcept { return m_data + m_size; }
+        const_iterator end() const noexcept { return m_data + m_size; }
+        const_iterator cend() const noexcept { return m_data + m_size; }
+
+        // Capacity
+        bool empty() const noexcept { return m_size == 0; }
+        size_t size() const noexcept { return m_size; }
+        size_t capacity() const noexcept { return m_capacity; }
+        bool isInline() const noexcept { return m_data == inlineData(); }
+
+        void reserve(size_t capacity) {
+            if (capacity > m_capacity) reallocate(capacity);
+        }
+
+        // Move a spilled vector back inline when it fits again, or trim the heap buffer
+        void shrinkToFit() {
+            if (isInline() || m_size == m_capacity) return;
+            if (m_size <= N) {
+                T* heap = m_data;
+                const size_t heapCapacity = m_capacity;
+                relocate(inlineData(), heap, m_size);
+                m_data = inlineData();
+                m_capacity = N;
+                std::allocator<T>{}.deallocate(heap, heapCapacity);
+            }
+            else {
+                reallocate(m_size);
+            }
+        }
+
+        // Modifiers
+        void clear() noexcept {
+            destroyAll();
+            m_size = 0;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args) {
+            if (m_size < m_capacity) {
+                T* slot = new (m_data + m_size) T(std::forward<Args>(args)...);
+                ++m_size;
+                return *slot;
+            }
+            // Construct into the new buffer before relocating, args may alias an existing element
+            const size_t newCapacity = growCapacity(m_size + 1);
+            T* newData = std::allocator<T>{}.allocate(newCapacity);
+            T* slot = nullptr;
+            try {
+                slot = new (newData + m_size) T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                std::allocator<T>{}.deallocate(newData, newCapacity);
+                throw;
+            }
+            try {
+                relocate(newData, m_data, m_size);
+            }
+            catch (...) {
+                std::destroy_at(slot);
+                std::allocator<T>{}.deallocate(newData, newCapacity);
+                throw;
+            }
+            freeHeap();
+            m_data = newData;
+            m_capacity = newCapacity;
+            ++m_size;
+            return *slot;
+        }
+
+        void pop_back() noexcept {
+            --m_size;
+            std::destroy_at(m_data + m_size);
+        }
+
+        template <typename... Args>
+        iterator emplace(const_iterator pos, Args&&... args) {
+            const size_t index = static_cast<size_t>(pos - m_data);
+            emplace_back(std::forward<Args>(args)...);
+            std::rotate(m_data + index, m_data + m_size - 1, m_data + m_size);
+            return m_data + index;
+        }
+        iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+        iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+        iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+        iterator erase(const_iterator first, const_iterator last) {
+            T* begin = m_data + (first - m_data);
+            T* end = m_data + (last - m_data);
+            if (begin != end) {
+                T* newEnd = std::move(end, m_data + m_size, begin);
+                std::destroy(newEnd, m_data + m_size);
+                m_size -= static_cast<size_t>(end - begin);
+            }
+            return begin;
+        }
+
+        void resize(size_t count) {
+            if (count < m_size) {
+                std::destroy(m_data + count, m_data + m_size);
+                m_size = count;
+                return;
+            }
+            reserve(count);
+            std::uninitialized_value_construct(m_data + m_size, m_data + count);
+            m_size = count;
+        }
+
+        void resize(size_t count, const T& value) {
+            if (count < m_size) {
+                std::destroy(m_data + count, m_data + m_size);
+                m_size = count;
+                return;
+            }
+            if (count > m_capacity) {
+                const T copy(value); // value may live inside this vector
+                reserve(count);
+                std::uninitialized_fill(m_data + m_size, m_data + count, copy);
+            }
+            else {
+                std::uninitialized_fill(m_data + m_size, m_data + count, value);
+            }
+            m_size = count;
+        }
+
+        template <size_t M>
+        bool operator==(const SmallVector<T, M>& other) const {
+            return std::equal(begin(), end(), other.begin(), other.end());
+        }
+
+    private:
+        static constexpr bool trivialRelocate = std::is_trivially_copyable_v<T>;
+
+        T* m_data{ inlineData() };
+        size_t m_size{ 0 };
+        size_t m_capacity{ N };
+        alignas(T) std::byte m_inline[sizeof(T) * N];
+
+        T* inlineData() noexcept { return std::launder(reinterpret_cast<T*>(m_inline)); }
+        const T* inlineData() const noexcept { return std::launder(reinterpret_cast<const T*>(m_inline)); }
+
+        size_t growCapacity(size_t minCapacity) const noexcept {
+            return std::max(minCapacity, m_capacity + m_capacity / 2);
+        }
+
+        // Chooses like std::move_if_noexcept: copying a T whose move may throw keeps src intact
+        static constexpr bool moveOnRelocate = std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>;
+
+        // Move count elements from src into uninitialized dst and end their lifetime in src. If a
+        // constructor throws, what was built in dst is destroyed and src keeps its elements
+        // (untouched unless T can only be moved), the guarantee std::vector gives on growth
+        static void relocate(T* dst, T* src, size_t count) noexcept(trivialRelocate || std::is_nothrow_move_constructible_v<T>) {
+            if constexpr (trivialRelocate) {
+                if (count) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+            }
+            else {
+                if constexpr (moveOnRelocate) std::uninitialized_move(src, src + count, dst);
+                else std::uninitialized_copy(src, src + count, dst);
+                std::destroy(src, src + count);
+            }
+        }
+
+        void reallocate(size_t capacity) {
+            T* newData = std::allocator<T>{}.allocate(capacity);
+            try {
+                relocate(newData, m_data, m_size);
+            }
+            catch (...) {
+                std::allocator<T>{}.deallocate(newData, capacity);
+                throw;
+            }
+            freeHeap();
+            m_data = newData;
+            m_capacity = capacity;
+        }
+
+        void destroyAll() noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                std::destroy(m_data, m_data + m_size);
+            }
+        }
+
+        void freeHeap() noexcept {
+            if (!isInline()) std::allocator<T>{}.deallocate(m_data, m_capacity);
+        }
+
+        // Expects this to be empty and inline. Inline elements are moved one by one, if one of those
+        // moves throws, this stays empty and other keeps its (partly moved-from) elements
+        void takeFrom(SmallVector&& other) {
+            if (other.isInline()) {
+                if constexpr (trivialRelocate) {
+                    relocate(inlineData(), other.m_data, other.m_size);
+                }
+                else {
+                    std::uninitialized_move(other.m_data, other.m_data + other.m_size, inlineData());
+                    std::destroy(other.m_data, other.m_data + other.m_size);
+                }
+                m_size = std::exchange(other.m_size, 0);
+            }
+            else {
+                m_data = std::exchange(other.m_data, other.inlineData());
+                m_size = std::exchange(other.m_size, 0);
+                m_capacity = std::exchange(other.m_capacity, N);
+            }
+        }
+    };
+
+}
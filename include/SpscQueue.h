@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace utl {
+
+    // Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    // Each side keeps its index on its own cache line next to a cached copy of the other
+    // side's index, so the common case never touches the shared line.
+    // The consumer claims elements with a CAS before reading them and releases them afterwards,
+    // which lets a producer that finds the queue full evict the oldest unclaimed element.
+    template <typename T, size_t Capacity>
+        requires (Capacity >= 2 && (Capacity & (Capacity - 1)) == 0)
+    class SpscQueue {
+    public:
+        static constexpr size_t capacity = Capacity;
+
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Producer: slot to fill in place, nullptr when full. Call publish() once it is written
+        T* reserve() noexcept {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedRelease == Capacity) {
+                m_cachedRelease = m_release.load(std::memory_order_acquire);
+                if (tail - m_cachedRelease == Capacity) return nullptr;
+            }
+            return &m_slots[tail & (Capacity - 1)];
+        }
+        void publish() noexcept {
+            m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Producer: when full, discard the oldest element so the next reserve() succeeds. Fails while
+        // the consumer is reading it or when evictable(oldest) says no; the producer is the only writer,
+        // so it may look at the element first. The evicted slot is handed back as is
+        template <typename F>
+        bool evictOldest(F&& evictable) {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            size_t oldest = m_release.load(std::memory_order_acquire);
+            if (tail - oldest != Capacity) return true;
+            if (!evictable(std::as_const(m_slots[oldest & (Capacity - 1)]))) return false;
+            size_t expected = oldest;
+            if (!m_claim.compare_exchange_strong(expected, oldest + 1, std::memory_order_acq_rel)) return false;
+            m_release.compare_exchange_strong(oldest, oldest + 1, std::memory_order_acq_rel);
+            m_cachedRelease = m_release.load(std::memory_order_acquire);
+            return true;
+        }
+
+        template <typename... Args>
+        bool tryEmplace(Args&&... args) {
+            T* slot = reserve();
+            if (!slot) return false;
+            *slot = T(std::forward<Args>(args)...);
+            publish();
+            return true;
+        }
+        bool tryPush(const T& value) { return tryEmplace(value); }
+        bool tryPush(T&& value) { return tryEmplace(std::move(value)); }
+
+        // Consumer: call function(T&) on every element pushed before position end (see produced()),
+        // claiming and releasing them as one batch
+        template <typename F>
+        size_t consumeUntil(size_t end, F&& function) {
+            return consume(end, SIZE_MAX, function);
+        }
+        template <typename F>
+        size_t consumeAll(F&& function) {
+            return consume(SIZE_MAX, SIZE_MAX, function);
+        }
+
+        bool tryPop(T& out) {
+            return consume(SIZE_MAX, 1, [&](T& value) { out = std::move(value); }) != 0;
+        }
+
+        // Total elements ever pushed / released, monotonic
+        size_t produced() const noexcept { return m_tail.load(std::memory_order_acquire); }
+        size_t released() const noexcept { return m_release.load(std::memory_order_acquire); }
+
+        // Slot of a position in [produced() - capacity, produced()), consumed or not. Racy while
+        // the producer is running, meant for post-mortem reads such as crash dumps
+        const T& at(size_t position) const noexcept { return m_slots[position & (Capacity - 1)]; }
+
+        // Approximate when called concurrently with the other side
+        size_t size() const noexcept { return produced() - released(); }
+        bool isEmpty() const noexcept { return size() == 0; }
+
+    private:
+        alignas(64) std::atomic_size_t m_claim{ 0 };    // consumer side, also advanced by eviction
+        std::atomic_size_t m_release{ 0 };
+        alignas(64) std::atomic_size_t m_tail{ 0 };     // producer side
+        size_t m_cachedRelease{ 0 };
+        alignas(64) std::array<T, Capacity> m_slots{};
+
+        template <typename F>
+        size_t consume(size_t end, size_t maxCount, F&& function) {
+            size_t claim = m_claim.load(std::memory_order_relaxed);
+            size_t count = 0;
+            do {
+                const size_t tail = std::min(m_tail.load(std::memory_order_acquire), end);
+                if (tail <= claim) return 0;
+                count = std::min(tail - claim, maxCount);
+            } while (!m_claim.compare_exchange_weak(claim, claim + count, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+            for (size_t i = 0; i < count; ++i) {
+                function(m_slots[(claim + i) & (Capacity - 1)]);
+            }
+            m_release.store(claim + count, std::memory_order_release);
+            return count;
+        }
+    };
+
+}
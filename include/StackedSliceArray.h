@@ -86,7 +86,7 @@ namespace util {
 			if (index >= currentSlices) return { nullptr,size_t(-1ll) };
 			const size_t start = map[index];
 			const size_t end = (index + 1 < currentSlices) ? map[index + 1] : dataSize;
-			const size_t length = end - start + 1;
+			const size_t length = end - start;
 			auto ptr = &data[start];
 			return { ptr,length };
 
@@ -118,7 +118,7 @@ namespace util {
 			return result;
 		}
 
-		std::span<T> operator[](const size_t index) const
+		std::span<T> operator[](const size_t index)
 		{
 			return get(index);
 		}
@@ -263,6 +263,7 @@ namespace utl::exp {
             m_lastFrameTime = now;
             m_nextFrameTime += m_targetFrameDuration;
             m_elapsedTime += m_deltaTime;
+            ++m_frameCount;
 
             m_accumulatedTime += m_deltaTime;
             if (m_accumulatedTime > m_maxAccumulatedTime) {
@@ -290,6 +291,7 @@ namespace utl::exp {
         inline double getElapsed() const noexcept { return std::chrono::duration<double>(m_elapsedTime).count(); }
         inline double getFixedStep() const noexcept { return std::chrono::duration<double>(m_fixedTargetFrameDuration).count(); }
         inline double getAccumulatedTime() const noexcept { return std::chrono::duration<double>(m_accumulatedTime).count(); }
+        inline uint64_t getFrameCount() const noexcept { return m_frameCount; }
 
 
     private:
@@ -315,6 +317,7 @@ namespace utl::exp {
         TimePoint m_nextFrameTime;
         Duration m_elapsedTime;
         Duration m_deltaTime;
+        uint64_t m_frameCount{ 0 };
     };
 
 
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define UTL_TSC_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define UTL_TSC_RDTSC 1
+#endif
+
+namespace utl {
+
+    // Cheapest monotonic tick counter the platform has: rdtsc on x86, the virtual counter on
+    // AArch64, steady_clock nanoseconds elsewhere. Ticks are only meaningful through a
+    // TscCalibration; the counter is assumed to be invariant and synchronized across cores,
+    // as it is on every x86 CPU of the last decade.
+    struct TscClock
+    {
+        static uint64_t ticks() noexcept
+        {
+#if defined(UTL_TSC_RDTSC)
+            return __rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+            uint64_t value;
+            asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+            return value;
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+    };
+
+    // Linear ticks to system_clock nanoseconds mapping, plain data so it can be copied anywhere
+    struct TscConversion
+    {
+        uint64_t anchorTicks = 0;
+        int64_t anchorNanos = 0;
+        double nanosPerTick = 1.0;
+
+        int64_t toUnixNanos(uint64_t ticks) const noexcept
+        {
+            return anchorNanos + static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - anchorTicks)) * nanosPerTick);
+        }
+    };
+
+    // Converts TscClock ticks to system_clock nanoseconds since the epoch. The rate is measured
+    // against the system clock over an ever longer baseline, so calling update() now and then
+    // (it is a no-op until interval has passed) refines it and follows wall clock adjustments.
+    // Not thread-safe: calibrate and convert from one thread.
+    class TscCalibration
+    {
+    public:
+        // Takes about a millisecond to get a first rate
+        explicit TscCalibration(std::chrono::nanoseconds interval = std::chrono::seconds(1));
+
+        void update();
+        // Recalibrate now
+        void recalibrate();
+
+        int64_t toUnixNanos(uint64_t ticks) const noexcept { return m_conversion.toUnixNanos(ticks); }
+        int64_t nowUnixNanos() const noexcept { return toUnixNanos(TscClock::ticks()); }
+        double ticksPerSecond() const noexcept { return 1e9 / m_conversion.nanosPerTick; }
+        const TscConversion& conversion() const noexcept { return m_conversion; }
+
+    private:
+        struct Sample
+        {
+            uint64_t ticks;
+            int64_t nanos;
+        };
+
+        std::chrono::nanoseconds m_interval;
+        Sample m_base{};                // first sample, the baseline the rate is measured over
+        TscConversion m_conversion;     // anchored at the most recent sample
+
+        static Sample sample() noexcept;
+    };
+
+}
@@ -0,0 +1,342 @@
+#include "BinaryLog.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace {
+    template <typename T>
+    void put(std::vector<char>& out, const T& value)
+    {
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename Length>
+    void putString(std::vector<char>& out, std::string_view str)
+    {
+        const auto length = static_cast<Length>(std::min<size_t>(str.size(), static_cast<Length>(~Length(0))));
+        put(out, length);
+        out.insert(out.end(), str.begin(), str.begin() + length);
+    }
+
+    template <typename T>
+    T get(std::istream& in)
+    {
+        T value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) throw std::runtime_error("binary log is truncated");
+        return value;
+    }
+
+    void getBytes(std::istream& in, void* out, size_t size)
+    {
+        if (size && !in.read(static_cast<char*>(out), static_cast<std::streamsize>(size))) throw std::runtime_error("binary log is truncated");
+    }
+
+    template <typename Length>
+    std::string getString(std::istream& in)
+    {
+        std::string str(get<Length>(in), '\0');
+        getBytes(in, str.data(), str.size());
+        return str;
+    }
+}
+
+
+Debug::BinaryLogWriter::BinaryLogWriter(const std::filesystem::path& path)
+    : m_file(path, std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    if (!m_file) throw std::runtime_error("BinaryLogWriter: cannot open " + path.string());
+    m_buffer.reserve(64 * 1024);
+    m_buffer.insert(m_buffer.end(), std::begin(BinaryLog::magic), std::end(BinaryLog::magic));
+    put(m_buffer, BinaryLog::version);
+    put(m_buffer, BinaryLog::endianCheck);
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    put(m_buffer, now);
+    flush();
+}
+
+Debug::BinaryLogWriter::~BinaryLogWriter()
+{
+    flush();
+}
+
+size_t Debug::BinaryLogWriter::SiteKeyHash::operator()(const SiteKey& key) const noexcept
+{
+    size_t hash = std::hash<const void*>{}(key.format);
+    hash ^= std::hash<const void*>{}(key.file) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    hash ^= (static_cast<size_t>(key.line) << 32 | key.column) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash ^ static_cast<size_t>(key.type) ^ (static_cast<size_t>(key.channel) << 8);
+}
+
+uint32_t Debug::BinaryLogWriter::siteId(const LogRecord& record, const std::string_view channel)
+{
+    const SiteKey key{ record.format, record.source.file_name(), record.source.line(), record.source.column(), record.type, record.channel };
+    const auto [it, inserted] = m_sites.try_emplace(key, static_cast<uint32_t>(m_sites.size()));
+    if (inserted) {
+        if (key.channel && !m_channels[key.channel]) {
+            m_channels[key.channel] = true;
+            put(m_buffer, BinaryLog::Frame::Channel);
+            put(m_buffer, key.channel);
+            putString<uint16_t>(m_buffer, channel);
+        }
+        put(m_buffer, BinaryLog::Frame::Site);
+        put(m_buffer, it->second);
+        put(m_buffer, static_cast<uint8_t>(record.type));
+        put(m_buffer, key.line);
+        put(m_buffer, key.column);
+        putString<uint16_t>(m_buffer, key.file ? key.file : "");
+        putString<uint16_t>(m_buffer, key.format ? key.format : "");
+        put(m_buffer, key.channel);
+    }
+    return it->second;
+}
+
+void Debug::BinaryLogWriter::write(const LogRecord& record, const int64_t timestamp, const std::string_view channel)
+{
+    const uint32_t site = siteId(record, channel);
+    if (record.text) {
+        put(m_buffer, BinaryLog::Frame::Text);
+        put(m_buffer, site);
+        put(m_buffer, timestamp);
+        putString<uint32_t>(m_buffer, *record.text);
+        return;
+    }
+    put(m_buffer, BinaryLog::Frame::Record);
+    put(m_buffer, site);
+    put(m_buffer, timestamp);
+    put(m_buffer, record.argCount);
+    put(m_buffer, record.payloadSize);
+    const auto* payload = reinterpret_cast<const char*>(record.payload.data());
+    m_buffer.insert(m_buffer.end(), payload, payload + record.payloadSize);
+}
+
+void Debug::BinaryLogWriter::writeDropped(const uint32_t threadIndex, const uint64_t count)
+{
+    put(m_buffer, BinaryLog::Frame::Dropped);
+    put(m_buffer, threadIndex);
+    put(m_buffer, count);
+}
+
+void Debug::BinaryLogWriter::writeSuppressed(const Log::Type type, const std::string_view file, const uint32_t line, const uint32_t column, const uint64_t count, const int64_t timestamp)
+{
+    put(m_buffer, BinaryLog::Frame::Suppressed);
+    put(m_buffer, static_cast<uint8_t>(type));
+    put(m_buffer, line);
+    put(m_buffer, column);
+    putString<uint16_t>(m_buffer, file);
+    put(m_buffer, count);
+    put(m_buffer, timestamp);
+}
+
+void Debug::BinaryLogWriter::flush()
+{
+    if (m_buffer.empty()) return;
+    m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_file.flush();
+    m_buffer.clear();
+}
+
+
+Debug::BinaryLogDumpWriter::BinaryLogDumpWriter(const int fd, const int64_t openedAt) noexcept : m_fd(fd)
+{
+    put(BinaryLog::magic, sizeof(BinaryLog::magic));
+    put(BinaryLog::version);
+    put(BinaryLog::endianCheck);
+    put(openedAt);
+}
+
+void Debug::BinaryLogDumpWriter::put(const void* bytes, size_t size) noexcept
+{
+    const auto* data = static_cast<const char*>(bytes);
+    while (size > 0) {
+        if (m_size == sizeof(m_buffer)) flush();
+        const size_t chunk = std::min(size, sizeof(m_buffer) - m_size);
+        std::memcpy(m_buffer + m_size, data, chunk);
+        m_size += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+template <typename Length>
+void Debug::BinaryLogDumpWriter::putString(const char* str, const size_t size) noexcept
+{
+    const auto length = static_cast<Length>(std::min<size_t>(size, static_cast<Length>(~Length(0))));
+    put(length);
+    put(str, length);
+}
+
+void Debug::BinaryLogDumpWriter::write(const LogRecord& record, const int64_t timestamp) noexcept
+{
+    const char* file = record.source.file_name() ? record.source.file_name() : "";
+    const char* format = record.format ? record.format : "";
+    const uint32_t site = m_sites++;
+    put(BinaryLog::Frame::Site);
+    put(site);
+    put(static_cast<uint8_t>(record.type));
+    put(record.source.line());
+    put(record.source.column());
+    putString<uint16_t>(file, std::strlen(file));
+    putString<uint16_t>(format, std::strlen(format));
+    put(record.channel);
+    if (record.text) {
+        put(BinaryLog::Frame::Text);
+        put(site);
+        put(timestamp);
+        putString<uint32_t>(record.text->data(), record.text->size());
+        return;
+    }
+    put(BinaryLog::Frame::Record);
+    put(site);
+    put(timestamp);
+    put(record.argCount);
+    const uint16_t payloadSize = std::min<uint16_t>(record.payloadSize, static_cast<uint16_t>(record.payload.size()));
+    put(payloadSize);
+    put(record.payload.data(), payloadSize);
+}
+
+void Debug::BinaryLogDumpWriter::writeChannel(const uint8_t id, const std::string_view name) noexcept
+{
+    put(BinaryLog::Frame::Channel);
+    put(id);
+    putString<uint16_t>(name.data(), name.size());
+}
+
+bool Debug::BinaryLogDumpWriter::flush() noexcept
+{
+    size_t done = 0;
+    while (done < m_size && !m_failed) {
+#ifdef _WIN32
+        const int written = _write(m_fd, m_buffer + done, static_cast<unsigned>(m_size - done));
+        if (written < 0) m_failed = true;
+#else
+        const ssize_t written = ::write(m_fd, m_buffer + done, m_size - done);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) m_failed = true;
+#endif
+        else done += static_cast<size_t>(written);
+    }
+    m_size = 0;
+    return !m_failed;
+}
+
+
+Debug::BinaryLogReader::BinaryLogReader(std::istream& in) : m_in(in)
+{
+    char magic[sizeof(BinaryLog::magic)]{};
+    m_in.read(magic, sizeof(magic));
+    if (!m_in || !std::equal(std::begin(magic), std::end(magic), std::begin(BinaryLog::magic)))
+        throw std::runtime_error("not a binary log");
+    m_version = get<uint32_t>(m_in);
+    if (m_version == 0 || m_version > BinaryLog::version) throw std::runtime_error("unsupported binary log version");
+    if (get<uint32_t>(m_in) != BinaryLog::endianCheck) throw std::runtime_error("binary log was written with a different byte order");
+    m_openedAt = get<int64_t>(m_in);
+}
+
+const Debug::BinaryLogReader::Site& Debug::BinaryLogReader::siteAt(const uint32_t id) const
+{
+    if (id >= m_sites.size()) throw std::runtime_error("binary log references an unknown call site");
+    return m_sites[id];
+}
+
+void Debug::BinaryLogReader::prefix(std::vector<char>& out, const Site& site, const int64_t timestamp)
+{
+    const bool continuation = m_prevSite && m_prevSite->file == site.file && m_prevSite->line == site.line && m_prevSite->column == site.column;
+    FormatLogPrefix(out, site.type, site.file, site.line, site.column, continuation, timestamp);
+    m_prevSite = &site;
+    m_channel = {};
+    if (site.channel) {
+        // Same tag as the logger's text, dumps may lack the name
+        std::string& name = m_channelNames[site.channel];
+        if (name.empty()) name = std::format("channel {}", site.channel);
+        m_channel = name;
+        std::format_to(std::back_inserter(out), "[{}] ", name);
+    }
+}
+
+bool Debug::BinaryLogReader::next(std::vector<char>& out)
+{
+    while (true) {
+        const int kind = m_in.get();
+        if (kind == std::char_traits<char>::eof()) return false;
+
+        switch (static_cast<BinaryLog::Frame>(kind)) {
+        case BinaryLog::Frame::Site: {
+            const auto id = get<uint32_t>(m_in);
+            if (id != m_sites.size()) throw std::runtime_error("binary log call sites are out of order");
+            Site site{};
+            site.type = static_cast<Log::Type>(get<uint8_t>(m_in));
+            site.line = get<uint32_t>(m_in);
+            site.column = get<uint32_t>(m_in);
+            site.file = getString<uint16_t>(m_in);
+            site.format = getString<uint16_t>(m_in);
+            if (m_version >= 4) site.channel = get<uint8_t>(m_in);
+            m_prevSite = nullptr; // growing m_sites may move it
+            m_sites.push_back(std::move(site));
+            continue;
+        }
+        case BinaryLog::Frame::Record: {
+            const Site& site = siteAt(get<uint32_t>(m_in));
+            const auto timestamp = get<int64_t>(m_in);
+            const auto argCount = get<uint8_t>(m_in);
+            m_payload.resize(get<uint16_t>(m_in));
+            getBytes(m_in, m_payload.data(), m_payload.size());
+            prefix(out, site, timestamp);
+            const size_t messageStart = out.size();
+            try {
+                FormatPayload(out, site.format, m_payload, argCount);
+            }
+            catch (const std::format_error& e) {
+                out.resize(messageStart);
+                std::format_to(std::back_inserter(out), "<format error: {}> {}", e.what(), site.format);
+            }
+            out.push_back('\n');
+            return true;
+        }
+        case BinaryLog::Frame::Text: {
+            const Site& site = siteAt(get<uint32_t>(m_in));
+            const auto timestamp = get<int64_t>(m_in);
+            m_text = getString<uint32_t>(m_in);
+            prefix(out, site, timestamp);
+            out.insert(out.end(), m_text.begin(), m_text.end());
+            out.push_back('\n');
+            return true;
+        }
+        case BinaryLog::Frame::Dropped: {
+            const auto threadIndex = get<uint32_t>(m_in);
+            const auto count = get<uint64_t>(m_in);
+            FormatDropNotice(out, count, threadIndex);
+            m_prevSite = nullptr;
+            m_channel = {};
+            return true;
+        }
+        case BinaryLog::Frame::Suppressed: {
+            const auto type = static_cast<Log::Type>(get<uint8_t>(m_in));
+            const auto line = get<uint32_t>(m_in);
+            const auto column = get<uint32_t>(m_in);
+            m_text = getString<uint16_t>(m_in);
+            const auto count = get<uint64_t>(m_in);
+            const auto timestamp = m_version >= 3 ? get<int64_t>(m_in) : 0;
+            FormatSuppressedNotice(out, type, m_text, line, column, count, timestamp);
+            m_prevSite = nullptr;
+            m_channel = {};
+            return true;
+        }
+        case BinaryLog::Frame::Channel: {
+            const auto id = get<uint8_t>(m_in);
+            m_channelNames[id] = getString<uint16_t>(m_in);
+            continue;
+        }
+        default:
+            throw std::runtime_error("binary log contains an unknown frame");
+        }
+    }
+}
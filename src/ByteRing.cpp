@@ -0,0 +1,177 @@
+#include "ByteRing.h"
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <memoryapi.h>
+#pragma comment(lib, "onecore.lib")
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    size_t allocationGranularity() noexcept
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwAllocationGranularity);
+#else
+        const long size = sysconf(_SC_PAGESIZE);
+        return size > 0 ? static_cast<size_t>(size) : size_t(4096);
+#endif
+    }
+
+    size_t roundCapacity(size_t minCapacity) noexcept
+    {
+        size_t capacity = allocationGranularity();
+        while (capacity < minCapacity) capacity <<= 1;
+        return capacity;
+    }
+
+#ifdef _WIN32
+    // Reserve a 2x placeholder, split it in half and map the same section into both halves
+    std::byte* mapMirrored(size_t capacity)
+    {
+        HANDLE section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(capacity) >> 32), static_cast<DWORD>(capacity & 0xFFFFFFFFu), nullptr);
+        if (!section) return nullptr;
+
+        auto* placeholder = static_cast<std::byte*>(VirtualAlloc2(nullptr, nullptr, 2 * capacity,
+            MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0));
+        if (!placeholder) {
+            CloseHandle(section);
+            return nullptr;
+        }
+        VirtualFree(placeholder, capacity, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+
+        void* first = MapViewOfFile3(section, nullptr, placeholder, 0, capacity, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+        void* second = first ? MapViewOfFile3(section, nullptr, placeholder + capacity, 0, capacity, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0) : nullptr;
+        CloseHandle(section); // the views keep the section alive
+        if (!second) {
+            if (first) UnmapViewOfFile(first);
+            else VirtualFree(placeholder, 0, MEM_RELEASE);
+            VirtualFree(placeholder + capacity, 0, MEM_RELEASE);
+            return nullptr;
+        }
+        return placeholder;
+    }
+
+    void unmapMirrored(std::byte* base, size_t capacity) noexcept
+    {
+        UnmapViewOfFile(base);
+        UnmapViewOfFile(base + capacity);
+    }
+#else
+    int createBackingFile(size_t capacity) noexcept
+    {
+#if defined(__linux__)
+        const int fd = memfd_create("utl-byte-ring", MFD_CLOEXEC);
+#else
+        // No memfd, use an immediately unlinked POSIX shared memory object
+        char name[64];
+        std::snprintf(name, sizeof(name), "/utl-byte-ring-%ld-%p", static_cast<long>(getpid()), static_cast<void*>(&name));
+        const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) shm_unlink(name);
+#endif
+        if (fd < 0) return -1;
+        if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Reserve 2x address space, then map the same file pages over both halves
+    std::byte* mapMirrored(size_t capacity)
+    {
+        const int fd = createBackingFile(capacity);
+        if (fd < 0) return nullptr;
+
+        void* reserved = mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        auto* base = static_cast<std::byte*>(reserved);
+        const bool mapped =
+            mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+            mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        close(fd); // the mappings keep the pages alive
+        if (!mapped) {
+            munmap(base, 2 * capacity);
+            return nullptr;
+        }
+        return base;
+    }
+
+    void unmapMirrored(std::byte* base, size_t capacity) noexcept
+    {
+        munmap(base, 2 * capacity);
+    }
+#endif
+
+}
+
+
+utl::ByteRing::ByteRing(const size_t minCapacity)
+{
+    const size_t capacity = roundCapacity(minCapacity ? minCapacity : 1);
+    m_base = mapMirrored(capacity);
+    if (!m_base) throw std::runtime_error("ByteRing: failed to create mirrored mapping");
+    m_mask = capacity - 1;
+}
+
+utl::ByteRing::~ByteRing()
+{
+    unmap();
+}
+
+utl::ByteRing::ByteRing(ByteRing&& other) noexcept
+    : m_base(std::exchange(other.m_base, nullptr)), m_mask(std::exchange(other.m_mask, 0)),
+    m_head(other.m_head.exchange(0)), m_tail(other.m_tail.exchange(0))
+{
+}
+
+utl::ByteRing& utl::ByteRing::operator=(ByteRing&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        m_base = std::exchange(other.m_base, nullptr);
+        m_mask = std::exchange(other.m_mask, 0);
+        m_head.store(other.m_head.exchange(0));
+        m_tail.store(other.m_tail.exchange(0));
+    }
+    return *this;
+}
+
+bool utl::ByteRing::write(const std::span<const std::byte> bytes) noexcept
+{
+    auto window = reserve(bytes.size());
+    if (window.size() != bytes.size()) return false;
+    if (!bytes.empty()) std::memcpy(window.data(), bytes.data(), bytes.size());
+    commit(bytes.size());
+    return true;
+}
+
+bool utl::ByteRing::read(const std::span<std::byte> out) noexcept
+{
+    const auto bytes = peek();
+    if (bytes.size() < out.size()) return false;
+    if (!out.empty()) std::memcpy(out.data(), bytes.data(), out.size());
+    consume(out.size());
+    return true;
+}
+
+void utl::ByteRing::unmap() noexcept
+{
+    if (m_base) unmapMirrored(m_base, capacity());
+    m_base = nullptr;
+    m_mask = 0;
+}
@@ -141,7 +141,7 @@ namespace utl {
 		template<typename T>
 		T* getCVarCurrent(uint64_t nameHash) noexcept {
 			std::shared_lock lock(m_sharedMutex);
-			auto* info = getCVar(nameHash);
+			auto* info = findCVar(nameHash);
 			if (!info) return nullptr;
 			auto* val = m_storage.getCurrentPtr(info->index);
 			if (!val) return nullptr;
@@ -151,7 +151,7 @@ namespace utl {
 		template <typename T>
 		bool setCVarCurrent(uint64_t nameHash, const T& value) noexcept {
 			std::unique_lock lock(m_sharedMutex);
-			auto* param = getCVar(nameHash);
+			auto* param = findCVar(nameHash);
 			if (!param) return false;
 			if (param->type != getCVarType<T>()) return false;
 			m_storage.setCurrent(param->index, CVarValue(value));
@@ -279,6 +279,12 @@ namespace utl {
 		CVarArray<g_maxCVars> m_storage;
 
 
+		// Caller holds m_sharedMutex, it is not recursive
+		CVarParameter* findCVar(uint64_t nameHash) noexcept {
+			const auto it = m_parameterMap.find(nameHash);
+			return it == m_parameterMap.end() ? nullptr : &it->second;
+		}
+
 		CVarParameter* initCVar(const std::string_view name, const  CVarType type, const CVarFlags flags, const std::string_view optDescription)
 		{
 			//std::unique_lock lock(mutex);
@@ -0,0 +1,127 @@
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Everything the handler touches is set up front, it must not allocate
+    std::filesystem::path::value_type g_dumpPath[4096];
+    std::atomic_bool g_installed = false;
+    std::atomic_bool g_crashing = false;
+
+    void dumpOnce() noexcept
+    {
+        if (g_crashing.exchange(true)) return;
+        Debug::Logger& logger = Debug::Logger::Instance();
+        logger.freeze(); // keep other threads, on any channel, off their buffers
+#ifdef _WIN32
+        const int fd = _wopen(g_dumpPath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd < 0) return;
+        logger.dumpFlightRecorder(fd);
+        _close(fd);
+#else
+        const int fd = ::open(g_dumpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return;
+        logger.dumpFlightRecorder(fd);
+        ::close(fd);
+#endif
+    }
+
+#ifdef _WIN32
+    LPTOP_LEVEL_EXCEPTION_FILTER g_previousFilter = nullptr;
+    void (*g_previousAbort)(int) = SIG_DFL;
+
+    LONG WINAPI onUnhandledException(EXCEPTION_POINTERS* info)
+    {
+        dumpOnce();
+        return g_previousFilter ? g_previousFilter(info) : EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    void onAbort(int signal)
+    {
+        dumpOnce();
+        std::signal(SIGABRT, g_previousAbort);
+        std::raise(signal);
+    }
+#else
+    constexpr int g_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+    struct sigaction g_previous[std::size(g_signals)];
+    std::unique_ptr<char[]> g_altStack;
+
+    void onFatalSignal(int signal, siginfo_t*, void*)
+    {
+        const int savedErrno = errno;
+        dumpOnce();
+        // Put the previous handler back and raise again, the signal is delivered to it as soon as
+        // this handler returns
+        for (size_t i = 0; i < std::size(g_signals); ++i) {
+            if (g_signals[i] == signal) sigaction(signal, &g_previous[i], nullptr);
+        }
+        errno = savedErrno;
+        raise(signal);
+    }
+#endif
+}
+
+
+void Debug::InstallCrashHandlers(const std::filesystem::path& dumpPath)
+{
+    const auto& native = dumpPath.native();
+    if (native.empty() || native.size() >= std::size(g_dumpPath)) throw std::runtime_error("InstallCrashHandlers: invalid dump path");
+    std::copy(native.begin(), native.end(), g_dumpPath);
+    g_dumpPath[native.size()] = 0;
+
+    Logger::Instance(); // constructed now, never inside the handler
+    if (g_installed.exchange(true)) return;
+    g_crashing = false;
+
+#ifdef _WIN32
+    g_previousFilter = SetUnhandledExceptionFilter(onUnhandledException);
+    g_previousAbort = std::signal(SIGABRT, onAbort);
+#else
+    if (!g_altStack) {
+        constexpr size_t altStackSize = 64 * 1024;
+        g_altStack = std::make_unique<char[]>(altStackSize);
+        stack_t stack{};
+        stack.ss_sp = g_altStack.get();
+        stack.ss_size = altStackSize;
+        sigaltstack(&stack, nullptr);
+    }
+    struct sigaction action{};
+    action.sa_sigaction = onFatalSignal;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < std::size(g_signals); ++i) {
+        if (sigaction(g_signals[i], &action, &g_previous[i]) != 0) {
+            g_installed = false;
+            throw std::runtime_error("InstallCrashHandlers: sigaction failed");
+        }
+    }
+#endif
+}
+
+void Debug::UninstallCrashHandlers() noexcept
+{
+    if (!g_installed.exchange(false)) return;
+#ifdef _WIN32
+    SetUnhandledExceptionFilter(g_previousFilter);
+    std::signal(SIGABRT, g_previousAbort);
+#else
+    for (size_t i = 0; i < std::size(g_signals); ++i) sigaction(g_signals[i], &g_previous[i], nullptr);
+#endif
+}
@@ -0,0 +1,304 @@
+#include "HeapProfiler.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+
+namespace {
+
+    constexpr size_t g_shardCount = 32;
+    constexpr size_t g_filterSize = 1 << 16;
+
+    struct StackTrace {
+        uint32_t depth{ 0 };
+        std::array<void*, utl::HeapProfiler::maxFrames> frames{};
+    };
+
+    struct StackStats {
+        StackTrace stack{};
+        uint64_t liveCount{ 0 };
+        uint64_t liveBytes{ 0 };
+        uint64_t allocCount{ 0 };
+        uint64_t allocBytes{ 0 };
+        // Unsampled estimates of the bytes behind the samples, see sampleWeight
+        double liveEstimate{ 0 };
+        double allocEstimate{ 0 };
+    };
+
+    struct LiveSample {
+        size_t bytes{ 0 };
+        double estimate{ 0 };
+        uint64_t stackHash{ 0 };
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<void*, LiveSample> samples;
+    };
+
+    std::atomic_size_t g_interval{ 0 };
+    std::array<Shard, g_shardCount> g_shards;
+    std::mutex g_stacksMutex;
+    std::unordered_map<uint64_t, StackStats> g_stacks;
+
+    // Counting filter over sampled pointers so that frees of unsampled memory never take a lock
+    std::array<std::atomic_uint16_t, g_filterSize> g_filter{};
+
+    thread_local int64_t t_bytesUntilSample{ 0 };
+    thread_local uint64_t t_rngState{ 0 };
+    thread_local bool t_inProfiler{ false };
+
+    // Keeps allocations made by the profiler itself out of the samples (and out of our locks)
+    struct ReentrancyGuard {
+        bool active;
+        ReentrancyGuard() noexcept : active(!t_inProfiler) { t_inProfiler = true; }
+        ~ReentrancyGuard() { if (active) t_inProfiler = false; }
+    };
+
+    inline size_t pointerHash(const void* ptr) noexcept {
+        auto value = reinterpret_cast<uintptr_t>(ptr);
+        value ^= value >> 17;
+        value *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(value >> 32);
+    }
+
+    inline Shard& shardFor(const void* ptr) noexcept { return g_shards[pointerHash(ptr) % g_shardCount]; }
+    inline std::atomic_uint16_t& filterFor(const void* ptr) noexcept { return g_filter[pointerHash(ptr) % g_filterSize]; }
+
+    // An allocation of bytes is sampled with probability 1 - exp(-bytes / interval), so each sample
+    // stands for bytes / that probability bytes of allocations from its call stack
+    double sampleWeight(size_t bytes, size_t interval) noexcept {
+        const double size = static_cast<double>(bytes);
+        const double probability = -std::expm1(-size / static_cast<double>(interval));
+        return probability > 0 ? size / probability : size;
+    }
+
+    // Exponentially distributed gap between samples, mean = interval
+    int64_t nextSampleGap(size_t interval) noexcept {
+        if (t_rngState == 0) {
+            t_rngState = reinterpret_cast<uintptr_t>(&t_rngState) * 0x9E3779B97F4A7C15ull | 1;
+        }
+        // xorshift64*
+        t_rngState ^= t_rngState >> 12;
+        t_rngState ^= t_rngState << 25;
+        t_rngState ^= t_rngState >> 27;
+        const uint64_t random = t_rngState * 0x2545F4914F6CDD1Dull;
+        const double uniform = (static_cast<double>(random >> 11) + 1.0) * (1.0 / 9007199254740993.0); // (0, 1]
+        return static_cast<int64_t>(-std::log(uniform) * static_cast<double>(interval)) + 1;
+    }
+
+#ifdef _WIN32
+    __declspec(noinline)
+#else
+    __attribute__((noinline))
+#endif
+    void captureStack(StackTrace& trace) noexcept {
+        constexpr int skip = 2; // captureStack and onAllocation
+        void* frames[utl::HeapProfiler::maxFrames + skip];
+#ifdef _WIN32
+        const int depth = CaptureStackBackTrace(0, static_cast<DWORD>(std::size(frames)), frames, nullptr);
+#else
+        const int depth = backtrace(frames, static_cast<int>(std::size(frames)));
+#endif
+        trace.depth = depth > skip ? static_cast<uint32_t>(depth - skip) : 0;
+        std::copy(frames + skip, frames + skip + trace.depth, trace.frames.begin());
+    }
+
+    uint64_t hashStack(const StackTrace& trace) noexcept {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0; i < trace.depth; ++i) {
+            hash = (hash ^ reinterpret_cast<uintptr_t>(trace.frames[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string symbolize(void* address) {
+#ifndef _WIN32
+        Dl_info info{};
+        if (dladdr(address, &info) && info.dli_sname) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = (status == 0 && demangled) ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+#endif
+        char buffer[2 + sizeof(void*) * 2 + 1];
+        std::snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+        return buffer;
+    }
+
+}
+
+
+void utl::HeapProfiler::start(const size_t sampleInterval) noexcept
+{
+    g_interval.store(sampleInterval ? sampleInterval : 1, std::memory_order_relaxed);
+}
+
+void utl::HeapProfiler::stop() noexcept
+{
+    g_interval.store(0, std::memory_order_relaxed);
+}
+
+void utl::HeapProfiler::reset()
+{
+    ReentrancyGuard guard;
+    for (auto& shard : g_shards) {
+        std::lock_guard lock(shard.mtx);
+        for (const auto& [ptr, sample] : shard.samples) {
+            filterFor(ptr).fetch_sub(1, std::memory_order_relaxed);
+        }
+        shard.samples.clear();
+    }
+    std::lock_guard lock(g_stacksMutex);
+    g_stacks.clear();
+}
+
+bool utl::HeapProfiler::isRunning() noexcept
+{
+    return g_interval.load(std::memory_order_relaxed) != 0;
+}
+
+size_t utl::HeapProfiler::sampleInterval() noexcept
+{
+    return g_interval.load(std::memory_order_relaxed);
+}
+
+void utl::HeapProfiler::onAllocation(void* ptr, const size_t bytes) noexcept
+{
+    const size_t interval = g_interval.load(std::memory_order_relaxed);
+    if (interval == 0 || t_inProfiler) return;
+
+    t_bytesUntilSample -= static_cast<int64_t>(bytes);
+    if (t_bytesUntilSample > 0) return;
+
+    ReentrancyGuard guard;
+    t_bytesUntilSample = nextSampleGap(interval);
+
+    StackTrace trace;
+    captureStack(trace);
+    const uint64_t stackHash = hashStack(trace);
+    const double estimate = sampleWeight(bytes, interval);
+
+    try {
+        {
+            std::lock_guard lock(g_stacksMutex);
+            auto& stats = g_stacks[stackHash];
+            if (stats.stack.depth == 0) stats.stack = trace;
+            ++stats.liveCount;
+            stats.liveBytes += bytes;
+            ++stats.allocCount;
+            stats.allocBytes += bytes;
+            stats.liveEstimate += estimate;
+            stats.allocEstimate += estimate;
+        }
+        auto& shard = shardFor(ptr);
+        std::lock_guard lock(shard.mtx);
+        shard.samples[ptr] = { bytes, estimate, stackHash };
+        filterFor(ptr).fetch_add(1, std::memory_order_release);
+    }
+    catch (...) {
+        // Out of memory while recording, lose the sample
+    }
+}
+
+void utl::HeapProfiler::onFree(void* ptr) noexcept
+{
+    if (t_inProfiler || filterFor(ptr).load(std::memory_order_acquire) == 0) return;
+
+    ReentrancyGuard guard;
+    LiveSample sample;
+    {
+        auto& shard = shardFor(ptr);
+        std::lock_guard lock(shard.mtx);
+        const auto it = shard.samples.find(ptr);
+        if (it == shard.samples.end()) return;
+        sample = it->second;
+        shard.samples.erase(it);
+        filterFor(ptr).fetch_sub(1, std::memory_order_relaxed);
+    }
+    std::lock_guard lock(g_stacksMutex);
+    if (const auto it = g_stacks.find(sample.stackHash); it != g_stacks.end()) {
+        --it->second.liveCount;
+        it->second.liveBytes -= sample.bytes;
+        it->second.liveEstimate = std::max(0.0, it->second.liveEstimate - sample.estimate);
+    }
+}
+
+void utl::HeapProfiler::writeFolded(std::ostream& os, const bool inUse)
+{
+    ReentrancyGuard guard;
+    std::vector<StackStats> stacks;
+    {
+        std::lock_guard lock(g_stacksMutex);
+        stacks.reserve(g_stacks.size());
+        for (const auto& [hash, stats] : g_stacks) stacks.push_back(stats);
+    }
+
+    std::unordered_map<void*, std::string> symbols;
+    for (const auto& stats : stacks) {
+        const auto bytes = static_cast<uint64_t>(std::llround(inUse ? stats.liveEstimate : stats.allocEstimate));
+        if ((inUse ? stats.liveCount : stats.allocCount) == 0 || bytes == 0) continue;
+        for (uint32_t i = stats.stack.depth; i-- > 0;) {
+            void* frame = stats.stack.frames[i];
+            auto it = symbols.find(frame);
+            if (it == symbols.end()) it = symbols.emplace(frame, symbolize(frame)).first;
+            os << it->second << (i ? ";" : "");
+        }
+        os << ' ' << bytes << '\n';
+    }
+}
+
+void utl::HeapProfiler::writePprof(std::ostream& os)
+{
+    ReentrancyGuard guard;
+    std::vector<StackStats> stacks;
+    {
+        std::lock_guard lock(g_stacksMutex);
+        stacks.reserve(g_stacks.size());
+        for (const auto& [hash, stats] : g_stacks) stacks.push_back(stats);
+    }
+
+    StackStats total;
+    for (const auto& stats : stacks) {
+        total.liveCount += stats.liveCount;
+        total.liveBytes += stats.liveBytes;
+        total.allocCount += stats.allocCount;
+        total.allocBytes += stats.allocBytes;
+    }
+
+    // Values are raw sample counts, pprof scales them back up using the interval in the header
+    os << "heap profile: " << total.liveCount << ": " << total.liveBytes << " [" << total.allocCount << ": " << total.allocBytes
+        << "] @ heap_v2/" << std::max<size_t>(sampleInterval(), 1) << '\n';
+    for (const auto& stats : stacks) {
+        os << stats.liveCount << ": " << stats.liveBytes << " [" << stats.allocCount << ": " << stats.allocBytes << "] @";
+        for (uint32_t i = 0; i < stats.stack.depth; ++i) {
+            os << " 0x" << std::hex << reinterpret_cast<uintptr_t>(stats.stack.frames[i]) << std::dec;
+        }
+        os << '\n';
+    }
+
+#ifdef __linux__
+    os << "\nMAPPED_LIBRARIES:\n";
+    std::ifstream maps("/proc/self/maps");
+    os << maps.rdbuf();
+#endif
+}
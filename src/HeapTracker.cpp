@@ -0,0 +1,320 @@
+#include "HeapTracker.h"
+#include "HeapProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+    // Fold thread counters into the globals after this many operations or this many bytes
+    constexpr uint32_t g_flushOps = 64;
+    constexpr uint64_t g_flushBytes = 256 * 1024;
+
+    struct alignas(64) GlobalCounters {
+        std::atomic_uint64_t allocatedBytes{ 0 };
+        std::atomic_uint64_t freedBytes{ 0 };
+        std::atomic_uint64_t allocations{ 0 };
+        std::atomic_uint64_t frees{ 0 };
+        std::atomic_uint64_t peakBytes{ 0 };
+    };
+    GlobalCounters g_counters;
+
+    struct TagSlot {
+        std::atomic_uint64_t hash{ 0 };
+        std::atomic<const char*> name{ nullptr };
+        std::atomic_size_t nameLength{ 0 };
+        std::atomic_uint64_t allocatedBytes{ 0 };
+        std::atomic_uint64_t allocations{ 0 };
+    };
+    std::array<TagSlot, utl::HeapTracker::maxTags> g_tags;
+    std::atomic_uint32_t g_tagCount{ 1 }; // 0 is untagged
+
+    enum class CounterState : uint8_t {
+        Fresh,      // nothing recorded on this thread yet
+        Active,
+        Exited      // flushed at thread exit, later records go straight to the globals
+    };
+
+    // Trivially destructible and constant initialized, so it stays usable from thread_local
+    // destructors that run after the exit flush
+    struct ThreadCounters {
+        uint64_t allocatedBytes;
+        uint64_t freedBytes;
+        uint64_t allocations;
+        uint64_t frees;
+        uint32_t ops;
+        uint32_t tag;
+        CounterState state;
+
+        void flush() noexcept {
+            if (ops == 0) return;
+            g_counters.allocatedBytes.fetch_add(allocatedBytes, std::memory_order_relaxed);
+            g_counters.freedBytes.fetch_add(freedBytes, std::memory_order_relaxed);
+            g_counters.allocations.fetch_add(allocations, std::memory_order_relaxed);
+            g_counters.frees.fetch_add(frees, std::memory_order_relaxed);
+            g_tags[tag].allocatedBytes.fetch_add(allocatedBytes, std::memory_order_relaxed);
+            g_tags[tag].allocations.fetch_add(allocations, std::memory_order_relaxed);
+
+            const uint64_t live = g_counters.allocatedBytes.load(std::memory_order_relaxed) - g_counters.freedBytes.load(std::memory_order_relaxed);
+            uint64_t peak = g_counters.peakBytes.load(std::memory_order_relaxed);
+            while (live > peak && live < (uint64_t(1) << 63) &&
+                !g_counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+            }
+
+            allocatedBytes = freedBytes = allocations = frees = 0;
+            ops = 0;
+        }
+    };
+    constinit thread_local ThreadCounters t_counters{};
+
+    // Folds the counters into the globals when the thread exits. Constructed on a thread's first record
+    struct ThreadCountersFlush {
+        ~ThreadCountersFlush() {
+            t_counters.flush();
+            t_counters.state = CounterState::Exited;
+        }
+    };
+    thread_local ThreadCountersFlush t_flush;
+
+    inline void activate(ThreadCounters& counters) noexcept {
+        if (counters.state == CounterState::Fresh) {
+            [[maybe_unused]] volatile auto* flush = &t_flush;
+            counters.state = CounterState::Active;
+        }
+    }
+
+    inline void maybeFlush(ThreadCounters& counters) noexcept {
+        if (++counters.ops >= g_flushOps || counters.allocatedBytes >= g_flushBytes ||
+            counters.freedBytes >= g_flushBytes || counters.state != CounterState::Active) {
+            counters.flush();
+        }
+    }
+
+    uint32_t findOrRegisterTag(const utl::StringHash& tag) noexcept {
+        const uint64_t hash = tag.hash ? tag.hash : 1;
+        const uint32_t count = g_tagCount.load(std::memory_order_acquire);
+        for (uint32_t i = 1; i < count; ++i) {
+            if (g_tags[i].hash.load(std::memory_order_acquire) == hash) return i;
+        }
+
+        // Claim a new slot. A racing registration of the same tag may produce a duplicate, which only splits its stats
+        const uint32_t index = g_tagCount.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= utl::HeapTracker::maxTags) {
+            g_tagCount.store(utl::HeapTracker::maxTags, std::memory_order_release);
+            return 0;
+        }
+        g_tags[index].name.store(tag.strView.data(), std::memory_order_relaxed);
+        g_tags[index].nameLength.store(tag.strView.size(), std::memory_order_relaxed);
+        g_tags[index].hash.store(hash, std::memory_order_release);
+        return index;
+    }
+
+}
+
+
+utl::HeapTracker::Scope::Scope(const StringHash tag) noexcept : m_previous(t_counters.tag)
+{
+    const uint32_t index = findOrRegisterTag(tag);
+    t_counters.flush();
+    t_counters.tag = index;
+}
+
+utl::HeapTracker::Scope::~Scope() noexcept
+{
+    t_counters.flush();
+    t_counters.tag = m_previous;
+}
+
+utl::HeapTracker::Snapshot utl::HeapTracker::snapshot() noexcept
+{
+    flushThread();
+    Snapshot result;
+    result.allocatedBytes = g_counters.allocatedBytes.load(std::memory_order_relaxed);
+    result.freedBytes = g_counters.freedBytes.load(std::memory_order_relaxed);
+    result.allocations = g_counters.allocations.load(std::memory_order_relaxed);
+    result.frees = g_counters.frees.load(std::memory_order_relaxed);
+    result.peakBytes = g_counters.peakBytes.load(std::memory_order_relaxed);
+    result.time = std::chrono::steady_clock::now();
+    return result;
+}
+
+utl::HeapTracker::Rate utl::HeapTracker::rate(const Snapshot& from, const Snapshot& to) noexcept
+{
+    const double seconds = std::chrono::duration<double>(to.time - from.time).count();
+    if (seconds <= 0.0) return {};
+    return {
+        static_cast<double>(to.allocatedBytes - from.allocatedBytes) / seconds,
+        static_cast<double>(to.allocations - from.allocations) / seconds,
+        static_cast<double>(to.frees - from.frees) / seconds,
+    };
+}
+
+size_t utl::HeapTracker::tagStats(std::span<TagStats> out) noexcept
+{
+    flushThread();
+    const size_t count = std::min<size_t>(g_tagCount.load(std::memory_order_acquire), maxTags);
+    size_t written = 0;
+    for (size_t i = 0; i < count && written < out.size(); ++i) {
+        const auto& slot = g_tags[i];
+        std::string_view name = "untagged";
+        if (i != 0) {
+            if (slot.hash.load(std::memory_order_acquire) == 0) continue; // still being registered
+            name = { slot.name.load(std::memory_order_relaxed), slot.nameLength.load(std::memory_order_relaxed) };
+        }
+        out[written++] = { name, slot.allocatedBytes.load(std::memory_order_relaxed), slot.allocations.load(std::memory_order_relaxed) };
+    }
+    return written;
+}
+
+void utl::HeapTracker::flushThread() noexcept
+{
+    t_counters.flush();
+}
+
+void utl::HeapTracker::recordAllocation(const size_t bytes) noexcept
+{
+    auto& counters = t_counters;
+    activate(counters);
+    counters.allocatedBytes += bytes;
+    ++counters.allocations;
+    maybeFlush(counters);
+}
+
+void utl::HeapTracker::recordFree(const size_t bytes) noexcept
+{
+    auto& counters = t_counters;
+    activate(counters);
+    counters.freedBytes += bytes;
+    ++counters.frees;
+    maybeFlush(counters);
+}
+
+
+#ifdef UTL_ENABLE_HEAP_TRACKER
+// Global operator new/delete overrides. Both sides account the allocator's usable size,
+// so unsized deletes balance exactly with their allocation.
+namespace {
+
+    inline size_t usableSize(void* ptr) noexcept
+    {
+#ifdef _WIN32
+        return _msize(ptr);
+#else
+        return malloc_usable_size(ptr);
+#endif
+    }
+
+    inline size_t usableSizeAligned(void* ptr, [[maybe_unused]] size_t alignment) noexcept
+    {
+#ifdef _WIN32
+        return _aligned_msize(ptr, alignment, 0);
+#else
+        return malloc_usable_size(ptr);
+#endif
+    }
+
+    inline void* trackedMalloc(size_t size) noexcept
+    {
+        void* ptr = std::malloc(size ? size : 1);
+        if (ptr) {
+            utl::HeapTracker::recordAllocation(usableSize(ptr));
+            utl::HeapProfiler::onAllocation(ptr, size);
+        }
+        return ptr;
+    }
+
+    inline void* trackedMallocAligned(size_t size, size_t alignment) noexcept
+    {
+        size = size ? size : 1;
+#ifdef _WIN32
+        void* ptr = _aligned_malloc(size, alignment);
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, std::max(alignment, sizeof(void*)), size) != 0) ptr = nullptr;
+#endif
+        if (ptr) {
+            utl::HeapTracker::recordAllocation(usableSizeAligned(ptr, alignment));
+            utl::HeapProfiler::onAllocation(ptr, size);
+        }
+        return ptr;
+    }
+
+    inline void trackedFree(void* ptr) noexcept
+    {
+        if (!ptr) return;
+        utl::HeapProfiler::onFree(ptr);
+        utl::HeapTracker::recordFree(usableSize(ptr));
+        std::free(ptr);
+    }
+
+    inline void trackedFreeAligned(void* ptr, [[maybe_unused]] size_t alignment) noexcept
+    {
+        if (!ptr) return;
+        utl::HeapProfiler::onFree(ptr);
+        utl::HeapTracker::recordFree(usableSizeAligned(ptr, alignment));
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    // Standard new semantics: retry through the new_handler, throw when there is none
+    inline void* newImpl(size_t size)
+    {
+        for (;;) {
+            if (void* ptr = trackedMalloc(size)) return ptr;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    inline void* newAlignedImpl(size_t size, size_t alignment)
+    {
+        for (;;) {
+            if (void* ptr = trackedMallocAligned(size, alignment)) return ptr;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    inline void* newNothrowImpl(size_t size) noexcept
+    {
+        try { return newImpl(size); }
+        catch (...) { return nullptr; }
+    }
+
+    inline void* newAlignedNothrowImpl(size_t size, size_t alignment) noexcept
+    {
+        try { return newAlignedImpl(size, alignment); }
+        catch (...) { return nullptr; }
+    }
+}
+
+void* operator new(size_t size) { return newImpl(size); }
+void* operator new[](size_t size) { return newImpl(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return newNothrowImpl(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return newNothrowImpl(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return newAlignedImpl(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return newAlignedImpl(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return newAlignedNothrowImpl(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return newAlignedNothrowImpl(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t alignment) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept { trackedFreeAligned(ptr, static_cast<size_t>(alignment)); }
+
+#endif
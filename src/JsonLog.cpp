@@ -0,0 +1,164 @@
+#include "JsonLog.h"
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <iterator>
+
+namespace {
+    template <typename T>
+    void appendNumber(std::vector<char>& out, T value)
+    {
+        char digits[32];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        out.insert(out.end(), digits, result.ptr);
+    }
+
+    // JSON has no NaN or infinity
+    template <typename T>
+    void appendFloat(std::vector<char>& out, T value)
+    {
+        if (std::isfinite(value)) appendNumber(out, value);
+        else out.insert(out.end(), { 'n', 'u', 'l', 'l' });
+    }
+
+    void appendLiteral(std::vector<char>& out, std::string_view text)
+    {
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    // ,"key":
+    void appendKey(std::vector<char>& out, std::string_view key)
+    {
+        out.push_back(',');
+        Debug::AppendJsonString(out, key);
+        out.push_back(':');
+    }
+
+    void appendValue(std::vector<char>& out, const Debug::LogArg& arg)
+    {
+        switch (arg.tag) {
+        case Debug::ArgTag::Int64: appendNumber(out, arg.i); break;
+        case Debug::ArgTag::UInt64: appendNumber(out, arg.u); break;
+        case Debug::ArgTag::Float: appendFloat(out, arg.f); break;
+        case Debug::ArgTag::Double: appendFloat(out, arg.d); break;
+        case Debug::ArgTag::Bool: appendLiteral(out, arg.b ? "true" : "false"); break;
+        case Debug::ArgTag::Char: Debug::AppendJsonString(out, std::string_view(&arg.c, 1)); break;
+        case Debug::ArgTag::Pointer: std::format_to(std::back_inserter(out), "\"{}\"", arg.p); break;
+        default: Debug::AppendJsonString(out, arg.str); break;
+        }
+    }
+
+    // {"ts":..,"level":..,"file":..,"line":..,"col":..
+    void appendHead(std::vector<char>& out, int64_t timestamp, Debug::Log::Type type, std::string_view file, uint32_t line, uint32_t column)
+    {
+        appendLiteral(out, "{\"ts\":");
+        appendNumber(out, timestamp);
+        appendKey(out, "level");
+        Debug::AppendJsonString(out, Debug::JsonLevelName(type));
+        if (file.empty()) return;
+        appendKey(out, "file");
+        Debug::AppendJsonString(out, file);
+        appendKey(out, "line");
+        appendNumber(out, line);
+        appendKey(out, "col");
+        appendNumber(out, column);
+    }
+}
+
+
+void Debug::AppendJsonString(std::vector<char>& out, const std::string_view str)
+{
+    constexpr char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    size_t run = 0; // start of the pending run of characters that need no escaping
+    for (size_t i = 0; i < str.size(); ++i) {
+        const auto c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.insert(out.end(), str.begin() + run, str.begin() + i);
+        run = i + 1;
+        out.push_back('\\');
+        switch (c) {
+        case '"': out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '\n': out.push_back('n'); break;
+        case '\r': out.push_back('r'); break;
+        case '\t': out.push_back('t'); break;
+        case '\b': out.push_back('b'); break;
+        case '\f': out.push_back('f'); break;
+        default: out.insert(out.end(), { 'u', '0', '0', hex[c >> 4], hex[c & 0xf] }); break;
+        }
+    }
+    out.insert(out.end(), str.begin() + run, str.end());
+    out.push_back('"');
+}
+
+std::string_view Debug::JsonLevelName(const Log::Type type) noexcept
+{
+    switch (type) {
+    case Log::Type::Trace: return "trace";
+    case Log::Type::Info: return "info";
+    case Log::Type::Warning: return "warning";
+    case Log::Type::Error: return "error";
+    case Log::Type::FatalError: return "fatal";
+    case Log::Type::Exception: return "exception";
+    case Log::Type::Assert: return "assert";
+    default: return "none";
+    }
+}
+
+void Debug::FormatJsonRecord(std::vector<char>& out, const LogRecord& record, const int64_t timestamp, const uint32_t threadIndex, const std::string_view channel)
+{
+    appendHead(out, timestamp, record.type, record.source.file_name(), record.source.line(), record.source.column());
+    appendKey(out, "thread");
+    appendNumber(out, threadIndex);
+    if (!channel.empty()) {
+        appendKey(out, "channel");
+        AppendJsonString(out, channel);
+    }
+    appendKey(out, "msg");
+
+    // Rendered into a reused scratch buffer and escaped from there, no allocation per record
+    thread_local std::vector<char> message;
+    message.clear();
+    LogArg args[LogRecord::maxArgs];
+    size_t argCount = 0;
+    try {
+        FormatRecord(message, record, false);
+        if (!record.text && record.format) argCount = DecodeArgs(std::span(record.payload.data(), record.payloadSize), record.argCount, args);
+    }
+    catch (const std::exception& e) {
+        message.clear();
+        std::format_to(std::back_inserter(message), "<format error: {}> {}", e.what(), record.format ? record.format : "");
+        argCount = 0;
+    }
+    AppendJsonString(out, std::string_view(message.data(), message.size()));
+
+    for (size_t i = 0; i < argCount; ++i) {
+        if (args[i].key.empty()) continue;
+        appendKey(out, args[i].key);
+        appendValue(out, args[i]);
+    }
+    appendLiteral(out, "}\n");
+}
+
+void Debug::FormatJsonDropNotice(std::vector<char>& out, const uint64_t count, const uint32_t threadIndex, const int64_t timestamp)
+{
+    appendHead(out, timestamp, Log::Type::Warning, {}, 0, 0);
+    appendKey(out, "thread");
+    appendNumber(out, threadIndex);
+    appendKey(out, "msg");
+    std::format_to(std::back_inserter(out), "\"Logger dropped {} logs from thread {}\"", count, threadIndex);
+    appendKey(out, "dropped");
+    appendNumber(out, count);
+    appendLiteral(out, "}\n");
+}
+
+void Debug::FormatJsonSuppressedNotice(std::vector<char>& out, const Log::Type type, const std::string_view file, const uint32_t line, const uint32_t column, const uint64_t count, const int64_t timestamp)
+{
+    appendHead(out, timestamp, type, file, line, column);
+    appendKey(out, "msg");
+    std::format_to(std::back_inserter(out), "\"message repeated {} more times (rate limited)\"", count);
+    appendKey(out, "suppressed");
+    appendNumber(out, count);
+    appendLiteral(out, "}\n");
+}
@@ -0,0 +1,211 @@
+#include "LogRecord.h"
+#include <charconv>
+#include <format>
+#include <iterator>
+
+namespace {
+    constexpr const char* g_textFormat = "{}";
+
+    template <typename T>
+    T readRaw(const std::byte*& pos, const std::byte* end)
+    {
+        T value;
+        if (static_cast<size_t>(end - pos) < sizeof(T)) throw std::format_error("truncated log payload");
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    template <typename F>
+    decltype(auto) visitArg(const Debug::LogArg& arg, F&& function)
+    {
+        switch (arg.tag) {
+        case Debug::ArgTag::Int64: return function(arg.i);
+        case Debug::ArgTag::UInt64: return function(arg.u);
+        case Debug::ArgTag::Float: return function(arg.f);
+        case Debug::ArgTag::Double: return function(arg.d);
+        case Debug::ArgTag::Bool: return function(arg.b);
+        case Debug::ArgTag::Char: return function(arg.c);
+        case Debug::ArgTag::Pointer: return function(arg.p);
+        default: return function(arg.str);
+        }
+    }
+
+    size_t parseIndex(std::string_view id)
+    {
+        size_t index = 0;
+        const auto [ptr, ec] = std::from_chars(id.data(), id.data() + id.size(), index);
+        if (ec != std::errc{} || ptr != id.data() + id.size()) throw std::format_error("invalid argument index");
+        return index;
+    }
+
+    const Debug::LogArg& argAt(std::span<const Debug::LogArg> args, size_t index)
+    {
+        if (index >= args.size()) throw std::format_error("argument index out of range");
+        return args[index];
+    }
+
+    // Replace nested {} / {n} width and precision fields with their integer values
+    void resolveSpec(std::string& resolved, std::string_view spec, std::span<const Debug::LogArg> args, size_t& autoIndex)
+    {
+        for (size_t i = 0; i < spec.size(); ++i) {
+            if (spec[i] != '{') {
+                resolved.push_back(spec[i]);
+                continue;
+            }
+            const size_t close = spec.find('}', i);
+            if (close == std::string_view::npos) throw std::format_error("unmatched '{' in format spec");
+            const std::string_view id = spec.substr(i + 1, close - i - 1);
+            const Debug::LogArg& arg = argAt(args, id.empty() ? autoIndex++ : parseIndex(id));
+            if (arg.tag != Debug::ArgTag::Int64 && arg.tag != Debug::ArgTag::UInt64) throw std::format_error("width/precision argument is not an integer");
+            std::format_to(std::back_inserter(resolved), "{}", arg.tag == Debug::ArgTag::Int64 ? arg.i : static_cast<int64_t>(arg.u));
+            i = close;
+        }
+    }
+
+    void formatArg(std::vector<char>& out, const Debug::LogArg& arg, std::string_view spec)
+    {
+        if (spec.empty()) {
+            if (arg.tag == Debug::ArgTag::String) out.insert(out.end(), arg.str.begin(), arg.str.end());
+            else visitArg(arg, [&](const auto& value) { std::format_to(std::back_inserter(out), "{}", value); });
+            return;
+        }
+        // "{:" + spec + "}", on the stack for the usual short specs
+        char stackFormat[64];
+        std::string heapFormat;
+        std::string_view format;
+        if (spec.size() + 3 <= sizeof(stackFormat)) {
+            stackFormat[0] = '{';
+            stackFormat[1] = ':';
+            std::memcpy(stackFormat + 2, spec.data(), spec.size());
+            stackFormat[spec.size() + 2] = '}';
+            format = { stackFormat, spec.size() + 3 };
+        }
+        else {
+            heapFormat.append("{:").append(spec).append("}");
+            format = heapFormat;
+        }
+        visitArg(arg, [&](const auto& value) {
+            std::vformat_to(std::back_inserter(out), format, std::make_format_args(value));
+            });
+    }
+}
+
+
+void Debug::SetRecordText(LogRecord& record, std::string text)
+{
+    details::ArgWriter writer(record.payload);
+    if (writer.putString(text)) {
+        record.format = g_textFormat;
+        record.payloadSize = static_cast<uint16_t>(writer.written(record.payload.data()));
+        record.argCount = 1;
+    }
+    else {
+        record.format = nullptr;
+        record.payloadSize = 0;
+        record.argCount = 0;
+        record.text = std::make_unique<std::string>(std::move(text));
+    }
+}
+
+size_t Debug::DecodeArgs(const std::span<const std::byte> payload, const size_t argCount, LogArg* out)
+{
+    const std::byte* pos = payload.data();
+    const std::byte* end = pos + payload.size();
+    for (size_t i = 0; i < argCount; ++i) {
+        LogArg& arg = out[i];
+        arg.key = {};
+        arg.tag = static_cast<ArgTag>(readRaw<uint8_t>(pos, end));
+        if (arg.tag == ArgTag::Key) {
+            const auto length = readRaw<uint16_t>(pos, end);
+            if (static_cast<size_t>(end - pos) < length) throw std::format_error("truncated log payload");
+            arg.key = { reinterpret_cast<const char*>(pos), length };
+            pos += length;
+            arg.tag = static_cast<ArgTag>(readRaw<uint8_t>(pos, end));
+        }
+        switch (arg.tag) {
+        case ArgTag::Int64: arg.i = readRaw<int64_t>(pos, end); break;
+        case ArgTag::UInt64: arg.u = readRaw<uint64_t>(pos, end); break;
+        case ArgTag::Float: arg.f = readRaw<float>(pos, end); break;
+        case ArgTag::Double: arg.d = readRaw<double>(pos, end); break;
+        case ArgTag::Bool: arg.b = readRaw<uint8_t>(pos, end) != 0; break;
+        case ArgTag::Char: arg.c = readRaw<char>(pos, end); break;
+        case ArgTag::Pointer: arg.p = readRaw<const void*>(pos, end); break;
+        case ArgTag::String: {
+            const auto length = readRaw<uint16_t>(pos, end);
+            if (static_cast<size_t>(end - pos) < length) throw std::format_error("truncated log payload");
+            arg.str = { reinterpret_cast<const char*>(pos), length };
+            pos += length;
+            break;
+        }
+        default:
+            throw std::format_error("unknown log argument tag");
+        }
+    }
+    return argCount;
+}
+
+void Debug::FormatPayload(std::vector<char>& out, const std::string_view format, const std::span<const std::byte> payload, const size_t argCount, const bool withFields)
+{
+    if (argCount > LogRecord::maxArgs) throw std::format_error("too many log arguments");
+    LogArg storage[LogRecord::maxArgs];
+    const std::span<const LogArg> args(storage, DecodeArgs(payload, argCount, storage));
+
+    std::string resolved;
+    size_t autoIndex = 0;
+    size_t i = 0;
+    while (i < format.size()) {
+        const size_t brace = format.find_first_of("{}", i);
+        if (brace == std::string_view::npos) {
+            out.insert(out.end(), format.begin() + i, format.end());
+            break;
+        }
+        out.insert(out.end(), format.begin() + i, format.begin() + brace);
+        if (brace + 1 < format.size() && format[brace + 1] == format[brace]) {
+            out.push_back(format[brace]); // {{ or }}
+            i = brace + 2;
+            continue;
+        }
+        if (format[brace] == '}') throw std::format_error("unmatched '}' in format string");
+
+        // Find the closing brace, the spec may hold nested {} fields
+        size_t close = brace + 1;
+        for (int depth = 1; close < format.size(); ++close) {
+            if (format[close] == '{') ++depth;
+            else if (format[close] == '}' && --depth == 0) break;
+        }
+        if (close >= format.size()) throw std::format_error("unmatched '{' in format string");
+
+        const std::string_view field = format.substr(brace + 1, close - brace - 1);
+        const size_t colon = field.find(':');
+        const std::string_view id = field.substr(0, colon);
+        const Debug::LogArg& arg = argAt(args, id.empty() ? autoIndex++ : parseIndex(id));
+        std::string_view spec = colon == std::string_view::npos ? std::string_view{} : field.substr(colon + 1);
+        if (spec.find('{') != std::string_view::npos) {
+            resolved.clear();
+            resolveSpec(resolved, spec, args, autoIndex);
+            spec = resolved;
+        }
+        formatArg(out, arg, spec);
+        i = close + 1;
+    }
+
+    if (!withFields) return;
+    for (const LogArg& arg : args) {
+        if (arg.key.empty()) continue;
+        out.push_back(' ');
+        out.insert(out.end(), arg.key.begin(), arg.key.end());
+        out.push_back('=');
+        formatArg(out, arg, {});
+    }
+}
+
+void Debug::FormatRecord(std::vector<char>& out, const LogRecord& record, const bool withFields)
+{
+    if (record.text) {
+        out.insert(out.end(), record.text->begin(), record.text->end());
+        return;
+    }
+    if (!record.format) return;
+    FormatPayload(out, record.format, std::span(record.payload.data(), record.payloadSize), record.argCount, withFields);
+}
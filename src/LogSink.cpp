@@ -0,0 +1,472 @@
+#include "LogSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    int openLogFile(const std::filesystem::path& path, bool append) noexcept
+    {
+#ifdef _WIN32
+        return _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC), _S_IREAD | _S_IWRITE);
+#else
+        return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+    }
+
+    void closeLogFile(int fd) noexcept
+    {
+#ifdef _WIN32
+        if (fd >= 0) _close(fd);
+#else
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+    uint64_t fileSize(int fd) noexcept
+    {
+#ifdef _WIN32
+        const __int64 size = _filelengthi64(fd);
+        return size > 0 ? static_cast<uint64_t>(size) : 0;
+#else
+        struct stat info {};
+        return fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+    }
+
+    // Reserve disk blocks past the end of the file without changing its size, so O_APPEND
+    // writes still land at the logical end. Best effort, unsupported filesystems are ignored
+    void preallocate(int fd, uint64_t bytes) noexcept
+    {
+#if defined(_WIN32)
+        FILE_ALLOCATION_INFO info{};
+        info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+        SetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), FileAllocationInfo, &info, sizeof(info));
+#elif defined(__linux__)
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#else
+        (void)fd;
+        (void)bytes;
+#endif
+    }
+
+    constexpr char g_ringMagic[8] = { 'U', 'T', 'L', 'R', 'I', 'N', 'G', '\0' };
+
+    // Give back preallocated blocks the segment never used
+    void trimToSize(int fd, uint64_t bytes) noexcept
+    {
+#ifdef _WIN32
+        _chsize_s(fd, static_cast<__int64>(bytes));
+#else
+        (void)!ftruncate(fd, static_cast<off_t>(bytes));
+#endif
+    }
+
+#ifdef _WIN32
+    bool writeAll(int fd, std::span<const std::string_view> batch)
+    {
+        for (std::string_view segment : batch) {
+            while (!segment.empty()) {
+                const unsigned chunk = static_cast<unsigned>(std::min<size_t>(segment.size(), 1u << 30));
+                const int written = _write(fd, segment.data(), chunk);
+                if (written < 0) return false;
+                segment.remove_prefix(static_cast<size_t>(written));
+            }
+        }
+        return true;
+    }
+#else
+    // One writev per batch, continuing after partial writes and interrupts
+    bool writeAll(int fd, std::span<const std::string_view> batch)
+    {
+#ifdef IOV_MAX
+        constexpr size_t maxSegments = IOV_MAX < 64 ? IOV_MAX : 64;
+#else
+        constexpr size_t maxSegments = 16;
+#endif
+        iovec iov[maxSegments];
+        size_t next = 0;        // first segment not yet in iov
+        size_t offset = 0;      // bytes of batch[next] already written
+        while (next < batch.size()) {
+            size_t count = 0;
+            for (size_t i = next; i < batch.size() && count < maxSegments; ++i) {
+                const size_t skip = i == next ? offset : 0;
+                if (batch[i].size() == skip) continue;
+                iov[count].iov_base = const_cast<char*>(batch[i].data() + skip);
+                iov[count].iov_len = batch[i].size() - skip;
+                ++count;
+            }
+            if (count == 0) return true;
+
+            ssize_t written = writev(fd, iov, static_cast<int>(count));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            // Advance next/offset past what was written
+            size_t remaining = static_cast<size_t>(written);
+            while (next < batch.size()) {
+                const size_t left = batch[next].size() - offset;
+                if (remaining < left) {
+                    offset += remaining;
+                    break;
+                }
+                remaining -= left;
+                offset = 0;
+                ++next;
+            }
+        }
+        return true;
+    }
+#endif
+}
+
+
+void Debug::FdLogSink::write(const std::span<const std::string_view> batch)
+{
+    if (m_fd < 0) return;
+    if (!writeAll(m_fd, batch)) m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Debug::FdLogSink::sync()
+{
+    if (m_fd < 0) return;
+#ifdef _WIN32
+    _commit(m_fd);
+#else
+    fsync(m_fd);
+#endif
+}
+
+Debug::ConsoleLogSink::ConsoleLogSink(const Stream stream) noexcept
+    : FdLogSink(stream == Stream::Out ? 1 : 2)
+{
+}
+
+Debug::FileLogSink::FileLogSink(const std::filesystem::path& path, const bool append)
+    : FdLogSink(openLogFile(path, append))
+{
+    if (m_fd < 0) throw std::runtime_error("FileLogSink: cannot open " + path.string());
+}
+
+Debug::FileLogSink::~FileLogSink()
+{
+    closeLogFile(m_fd);
+}
+
+
+Debug::RotatingFileLogSink::RotatingFileLogSink(Options options)
+    : FdLogSink(-1), m_options(std::move(options))
+{
+    open(true);
+    if (m_fd < 0) throw std::runtime_error("RotatingFileLogSink: cannot open " + m_options.path.string());
+}
+
+Debug::RotatingFileLogSink::~RotatingFileLogSink()
+{
+    close();
+}
+
+std::filesystem::path Debug::RotatingFileLogSink::segmentPath(const uint32_t index) const
+{
+    if (index == 0) return m_options.path;
+    std::filesystem::path path = m_options.path;
+    path.replace_filename(std::format("{}.{}{}", m_options.path.stem().string(), index, m_options.path.extension().string()));
+    return path;
+}
+
+void Debug::RotatingFileLogSink::open(const bool append)
+{
+    m_fd = openLogFile(m_options.path, append);
+    m_segmentBytes = m_fd >= 0 ? fileSize(m_fd) : 0;
+    m_openedAt = std::chrono::steady_clock::now();
+    if (m_fd >= 0 && m_options.preallocate && m_options.maxBytes > m_segmentBytes) {
+        preallocate(m_fd, m_options.maxBytes);
+    }
+}
+
+void Debug::RotatingFileLogSink::close() noexcept
+{
+    if (m_fd < 0) return;
+    if (m_options.preallocate) trimToSize(m_fd, m_segmentBytes);
+    closeLogFile(m_fd);
+    m_fd = -1;
+}
+
+void Debug::RotatingFileLogSink::rotate()
+{
+    close();
+    std::error_code ec;
+    if (m_options.maxFiles == 0) {
+        std::filesystem::remove(m_options.path, ec);
+    }
+    else {
+        std::filesystem::remove(segmentPath(m_options.maxFiles), ec);
+        for (uint32_t i = m_options.maxFiles; i > 0; --i) {
+            std::filesystem::rename(segmentPath(i - 1), segmentPath(i), ec);
+        }
+    }
+    open(false);
+    ++m_rotations;
+}
+
+void Debug::RotatingFileLogSink::write(const std::span<const std::string_view> batch)
+{
+    uint64_t bytes = 0;
+    for (std::string_view segment : batch) bytes += segment.size();
+    if (bytes == 0) return;
+
+    const bool full = m_options.maxBytes && m_segmentBytes > 0 && m_segmentBytes + bytes > m_options.maxBytes;
+    const bool old = m_options.maxAge.count() > 0 && std::chrono::steady_clock::now() - m_openedAt >= m_options.maxAge;
+    if (full || old || m_fd < 0) rotate();
+
+    FdLogSink::write(batch);
+    m_segmentBytes += bytes;
+}
+
+
+Debug::RingLogSink::RingLogSink(const size_t capacity) : m_ring(std::max<size_t>(capacity, 1))
+{
+}
+
+void Debug::RingLogSink::write(const std::span<const std::string_view> batch)
+{
+    std::lock_guard lock(m_mutex);
+    const size_t capacity = m_ring.size();
+    for (std::string_view segment : batch) {
+        if (segment.size() >= capacity) {
+            segment = segment.substr(segment.size() - capacity);
+            std::copy(segment.begin(), segment.end(), m_ring.begin());
+            m_head = 0;
+            m_size = capacity;
+            continue;
+        }
+        const size_t first = std::min(segment.size(), capacity - m_head);
+        std::copy_n(segment.begin(), first, m_ring.begin() + static_cast<std::ptrdiff_t>(m_head));
+        std::copy(segment.begin() + static_cast<std::ptrdiff_t>(first), segment.end(), m_ring.begin());
+        m_head = (m_head + segment.size()) % capacity;
+        m_size = std::min(capacity, m_size + segment.size());
+    }
+}
+
+std::string Debug::RingLogSink::contents() const
+{
+    std::lock_guard lock(m_mutex);
+    std::string text;
+    text.reserve(m_size);
+    const size_t start = (m_head + m_ring.size() - m_size) % m_ring.size();
+    const size_t first = std::min(m_size, m_ring.size() - start);
+    text.append(m_ring.data() + start, first);
+    text.append(m_ring.data(), m_size - first);
+    return text;
+}
+
+void Debug::RingLogSink::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_head = 0;
+    m_size = 0;
+}
+
+
+Debug::MappedRingLogSink::MappedRingLogSink(const std::filesystem::path& path, const size_t capacity)
+{
+    m_mappedBytes = sizeof(Header) + std::max<size_t>(capacity, 1);
+    void* view = nullptr;
+#ifdef _WIN32
+    m_file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file != INVALID_HANDLE_VALUE) {
+        const auto size = static_cast<uint64_t>(m_mappedBytes);
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (m_mapping) view = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_mappedBytes);
+    }
+    if (!view) {
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        throw std::runtime_error("MappedRingLogSink: cannot map " + path.string());
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(m_mappedBytes)) == 0) {
+        view = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) view = nullptr;
+    }
+    if (fd >= 0) ::close(fd); // the mapping keeps the file
+    if (!view) throw std::runtime_error("MappedRingLogSink: cannot map " + path.string());
+#endif
+    m_header = static_cast<Header*>(view);
+    m_ring = static_cast<char*>(view) + sizeof(Header);
+    std::memcpy(m_header->magic, g_ringMagic, sizeof(g_ringMagic));
+    m_header->capacity = m_mappedBytes - sizeof(Header);
+    m_header->head = 0;
+    m_header->size = 0;
+}
+
+Debug::MappedRingLogSink::~MappedRingLogSink()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(m_header);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    munmap(m_header, m_mappedBytes);
+#endif
+}
+
+// Text first, then the header, so a crash in between leaves the previous state readable
+void Debug::MappedRingLogSink::write(const std::span<const std::string_view> batch)
+{
+    const size_t capacity = m_header->capacity;
+    size_t head = m_header->head;
+    size_t size = m_header->size;
+    for (std::string_view segment : batch) {
+        if (segment.size() >= capacity) segment = segment.substr(segment.size() - capacity);
+        const size_t first = std::min(segment.size(), capacity - head);
+        std::memcpy(m_ring + head, segment.data(), first);
+        std::memcpy(m_ring, segment.data() + first, segment.size() - first);
+        head = (head + segment.size()) % capacity;
+        size = std::min(capacity, size + segment.size());
+    }
+    m_header->head = head;
+    m_header->size = size;
+}
+
+void Debug::MappedRingLogSink::flush()
+{
+#ifdef _WIN32
+    FlushViewOfFile(m_header, m_mappedBytes);
+#else
+    msync(m_header, m_mappedBytes, MS_ASYNC);
+#endif
+}
+
+void Debug::MappedRingLogSink::sync()
+{
+#ifdef _WIN32
+    FlushViewOfFile(m_header, m_mappedBytes);
+    FlushFileBuffers(m_file);
+#else
+    msync(m_header, m_mappedBytes, MS_SYNC);
+#endif
+}
+
+std::string Debug::MappedRingLogSink::read(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    Header header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, g_ringMagic, sizeof(g_ringMagic)) != 0 ||
+        header.size > header.capacity || header.head >= header.capacity)
+        throw std::runtime_error("not a log ring file: " + path.string());
+    std::string ring(header.capacity, '\0');
+    if (!file.read(ring.data(), static_cast<std::streamsize>(ring.size()))) throw std::runtime_error("log ring file is truncated: " + path.string());
+    const size_t start = (header.head + header.capacity - header.size) % header.capacity;
+    const size_t first = std::min<size_t>(header.size, header.capacity - start);
+    std::string text = ring.substr(start, first);
+    text.append(ring, 0, header.size - first);
+    return text;
+}
+
+
+Debug::AsyncLogSink::AsyncLogSink(std::shared_ptr<LogSink> sink, const size_t maxPendingBytes)
+    : m_sink(std::move(sink)), m_maxPendingBytes(maxPendingBytes)
+{
+    if (!m_sink) throw std::invalid_argument("AsyncLogSink needs a sink to wrap");
+    m_pending.reserve(std::min<size_t>(maxPendingBytes, 64 * 1024));
+    m_thread = std::thread(&AsyncLogSink::run, this);
+}
+
+Debug::AsyncLogSink::~AsyncLogSink()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+void Debug::AsyncLogSink::write(const std::span<const std::string_view> batch)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        for (std::string_view segment : batch) {
+            if (m_pending.size() + segment.size() > m_maxPendingBytes) {
+                m_pendingDrops += segment.size();
+                m_droppedBytes.fetch_add(segment.size(), std::memory_order_relaxed);
+                continue;
+            }
+            m_pending.insert(m_pending.end(), segment.begin(), segment.end());
+        }
+        ++m_queued;
+    }
+    m_cv.notify_one();
+}
+
+void Debug::AsyncLogSink::flush()
+{
+    waitWritten();
+    m_sink->flush();
+}
+
+void Debug::AsyncLogSink::sync()
+{
+    waitWritten();
+    m_sink->sync();
+}
+
+// Wait until every batch accepted so far reached the wrapped sink
+void Debug::AsyncLogSink::waitWritten()
+{
+    std::unique_lock lock(m_mutex);
+    const uint64_t target = m_queued;
+    m_flushedCv.wait(lock, [&] { return m_written >= target || !m_running; });
+}
+
+void Debug::AsyncLogSink::run()
+{
+    std::vector<char> writing;
+    std::string notice;
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this] { return m_queued != m_written || !m_running; });
+        if (m_queued == m_written && !m_running) break;
+
+        writing.swap(m_pending);
+        const uint64_t drops = std::exchange(m_pendingDrops, 0);
+        const uint64_t batches = m_queued;
+        lock.unlock();
+
+        notice.clear();
+        if (drops) notice = std::format("[WARNING] AsyncLogSink dropped {} bytes of log text\n", drops);
+        const std::string_view segments[2] = { std::string_view(writing.data(), writing.size()), notice };
+        try {
+            m_sink->write(std::span(segments, notice.empty() ? 1 : 2));
+        }
+        catch (...) {
+            // A failing sink must not take the logger down with it
+        }
+        writing.clear();
+
+        lock.lock();
+        m_written = batches;
+        m_flushedCv.notify_all();
+    }
+}
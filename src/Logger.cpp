@@ -1,8 +1,17 @@
 #include "AnsiCodes.h"
+#include "BinaryLog.h"
+#include "CVarSystem.h"
+#include "JsonLog.h"
 #include "Logger.h"
+#include "SpscQueue.h"
+#include <algorithm>
+#include <bit>
+#include <ctime>
 #include <fstream>
 #include <iostream>
+#include <deque>
 #include <sstream>
+#include <unordered_map>
 
 namespace {
 #ifdef LOGGER_USE_ANSI
@@ -35,16 +44,169 @@ namespace {
 }
 
 
-Debug::Logger::Logger() : logMask(g_allLogTypes), messageQueue(), tempQueue(), readyFuture(readyPromise.get_future().share())
+struct Debug::Logger::ThreadBuffer
 {
+    utl::SpscQueue<LogRecord, threadBufferCapacity> queue;
+    std::atomic_uint64_t dropped = 0;   // written by the owning thread only
+    // Sequence numbers for flush: records committed by the owning thread, records evicted by it
+    // under DropOldest, and records the logger thread has handed to the sinks
+    std::atomic_uint64_t committed = 0;
+    std::atomic_uint64_t evicted = 0;
+    std::atomic_uint64_t written = 0;
+    uint64_t passWritten = 0;           // logger thread only, published to written after the pass
+    // Overflow for the Spill policy. While spillPending is set every new record goes here, so
+    // the logger can write the queue first and the spill after it without reordering
+    std::mutex spillMtx;
+    std::vector<std::unique_ptr<LogRecord>> spill;
+    std::atomic_size_t spillSize = 0;
+    std::atomic_bool spillPending = false;
+    std::unique_ptr<LogRecord> pendingSpill; // reserved but not committed, owning thread only
+    std::atomic_bool retired = false;   // set when the owning thread exits
+    uint64_t reportedDrops = 0;         // logger thread only
+    uint32_t threadIndex = 0;
+};
+
+// Retire the buffer on thread exit, the logger thread drains whatever is left and then forgets it
+Debug::Logger::ThreadBufferHandle::~ThreadBufferHandle()
+{
+    if (buffer) buffer->retired.store(true, std::memory_order_release);
+}
+
+thread_local Debug::Logger::ThreadBufferHandle Debug::Logger::localHandle;
+
+namespace {
+    std::atomic_uint32_t g_threadCounter = 0;
+
+    // Monotonic ns for the rate limiter, a few ms of resolution is plenty and it is several times cheaper
+    int64_t coarseNow() noexcept
+    {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Rate limit state of one call site, shared by every thread logging from it
+    struct CallSite
+    {
+        const char* file;
+        uint32_t line;
+        uint32_t column;
+        Debug::Log::Type type;
+        std::atomic_int64_t allowedAt{ 0 };     // coarseNow() ns, the bucket is empty until then
+        alignas(64) std::atomic_uint64_t suppressed{ 0 };   // not reported yet
+        uint64_t reported = 0;                  // logger thread only
+
+        // GCRA form of the token bucket: one atomic, and a site that is over its limit only loads it
+        bool tryAcquire(const int64_t now, const int64_t interval, const int64_t tolerance) noexcept
+        {
+            int64_t next = allowedAt.load(std::memory_order_relaxed);
+            while (true) {
+                const int64_t start = std::max(next, now);
+                if (start - now > tolerance) return false;
+                if (allowedAt.compare_exchange_weak(next, start + interval, std::memory_order_relaxed)) return true;
+            }
+        }
+    };
+
+    struct CallSiteKey
+    {
+        const char* file;
+        uint32_t line;
+        uint32_t column;
+        bool operator==(const CallSiteKey&) const = default;
+    };
+
+    struct CallSiteKeyHash
+    {
+        size_t operator()(const CallSiteKey& key) const noexcept
+        {
+            return std::hash<const void*>{}(key.file) ^ (static_cast<size_t>(key.line) * 0x9e3779b97f4a7c15ull + key.column);
+        }
+    };
+
+    // Direct mapped per-thread cache in front of the shared registry, so a hot site never locks
+    struct CallSiteCacheEntry
+    {
+        CallSiteKey key{};
+        CallSite* site = nullptr;
+    };
+    thread_local std::array<CallSiteCacheEntry, 64> t_callSiteCache{};
+
+    size_t typeIndex(const Debug::Log::Type type) noexcept
+    {
+        return std::min<size_t>(std::countr_zero(static_cast<unsigned>(type)), 6);
+    }
+
+    bool isSevere(const Debug::Log::Type type) noexcept
+    {
+        return static_cast<int>(type) >= static_cast<int>(Debug::Log::Type::Error);
+    }
+
+    void countDrop(std::atomic_uint64_t& threadDrops, std::atomic_uint64_t& total) noexcept
+    {
+        threadDrops.store(threadDrops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+struct Debug::Logger::CallSites
+{
+    std::mutex mtx;
+    std::deque<CallSite> sites;     // stable addresses for the thread caches
+    std::unordered_map<CallSiteKey, CallSite*, CallSiteKeyHash> index;
+
+    CallSite& find(const Log::Type type, const std::source_location& source)
+    {
+        const CallSiteKey key{ source.file_name(), source.line(), source.column() };
+        CallSiteCacheEntry& cached = t_callSiteCache[CallSiteKeyHash{}(key) % t_callSiteCache.size()];
+        if (cached.site && cached.key == key) return *cached.site;
+
+        std::lock_guard lock(mtx);
+        auto [it, inserted] = index.try_emplace(key, nullptr);
+        if (inserted) {
+            CallSite& site = sites.emplace_back();
+            site.file = key.file;
+            site.line = key.line;
+            site.column = key.column;
+            site.type = type;
+            it->second = &site;
+        }
+        cached = { key, it->second };
+        return *it->second;
+    }
+};
+
+Debug::Logger::Logger()
+    : logMask(g_allLogTypes.getMask()), callSites(std::make_unique<CallSites>()),
+    rateBurst(RateLimit{}.burst), ratePerSecond(RateLimit{}.perSecond), readyFuture(readyPromise.get_future().share())
+{
+    for (auto& policy : backpressure) policy.store(Backpressure::DropNewest);
+    // Channels poll their CVars until the logger thread stops, the CVar system has to outlive us
+    utl::CVarSystem::getInstance();
+    // The console gets its own thread so a slow terminal never holds up the file
+    sinks.push_back(std::make_shared<AsyncLogSink>(std::make_shared<ConsoleLogSink>()));
+    try {
+        sinks.push_back(std::make_shared<RotatingFileLogSink>(RotatingFileLogSink::Options{}));
+    }
+    catch (const std::exception&) {
+        // Read-only working directory, keep logging to the console
+    }
     thread = std::thread(&Logger::runAsync, this);
 }
 Debug::Logger::~Logger()
 {
     flush();
     running.store(false);
-    cv.notify_one();
+    wake();
     thread.join();
+    // Release flushes that raced with shutdown
+    passesWritten.fetch_add(1, std::memory_order_release);
+    passesWritten.notify_all();
 }
 
 static void PrintOut(Debug::Log& log, std::ostream& stream)
@@ -69,81 +231,504 @@ static void formatLog(std::vector<char>& buffer, const Debug::Log& log) {
 
 void Debug::Logger::runAsync()
 {
-    std::ostringstream oss;
-    std::fstream file{ "log.txt", std::ios::out | std::ios::app };
-    std::source_location prevSource{}; // Temp unused
+    std::source_location prevSource{};
+    std::vector<std::shared_ptr<LogSink>> activeSinks;
+    utl::TscCalibration clock;
     readyPromise.set_value();
 
     std::vector<char> buffer;
-    buffer.reserve(1024);
-    while (running) {
+    buffer.reserve(64 * 1024);
+    std::vector<std::shared_ptr<ThreadBuffer>> active;
+    std::vector<std::unique_ptr<LogRecord>> spilled;
+
+    // Logger thread view of the channels, indexed by id
+    struct ChannelOutput
+    {
+        LogChannel* channel = nullptr;
+        std::vector<std::shared_ptr<LogSink>> sinks;
+        std::vector<char> buffer;       // text for the channel's own sinks
+        std::source_location prevSource{};
+        int64_t verbosity = 0;          // CVar value last applied
+    };
+    std::vector<ChannelOutput> outputs(1);
+    int64_t nextCVarPoll = 0;
+    auto syncChannels = [&]() {
+        std::lock_guard lock(channelMtx);
+        outputs.resize(channels.size() + 1);
+        for (const auto& channel : channels) {
+            ChannelOutput& output = outputs[channel->id()];
+            if (!output.channel) {
+                output.channel = channel.get();
+                output.verbosity = channel->m_verbosity.load(std::memory_order_relaxed);
+            }
+            std::lock_guard sinkLock(channel->m_sinkMutex);
+            output.sinks = channel->m_sinks;
+        }
+        };
+    auto writeSinks = [](const std::vector<std::shared_ptr<LogSink>>& targets, std::vector<char>& text) {
+        if (text.empty()) return;
+        const std::string_view batch(text.data(), text.size());
+        for (auto& sink : targets) {
+            try {
+                sink->write(std::span(&batch, 1));
+            }
+            catch (...) {
+                // A failing sink must not take the logger thread down
+            }
+        }
+        text.clear();
+        };
+
+    // One pass over every thread buffer, returns how many logs were written
+    auto drain = [&]() -> size_t {
         {
-            std::unique_lock lock(mtx);
-            cv.wait(lock, [this] {
-                return !messageQueue.isEmpty() || !running;
-                });
-            messageQueue.swap(tempQueue);
-            lock.unlock();
-        }
-        messageQueue.lock();
-        Log log;
-        while (tempQueue.dequeueUnsafe(log)) {
-            buffer.clear();
-            if (prevSource == log.source)
-                std::format_to(std::back_inserter(buffer), "|> {}\n", log.message);
-            else
-                std::format_to(std::back_inserter(buffer), "{} {}({},{}):\n|> {}\n",
-                    StreamLogType(log.type),
-                    log.source.file_name(), log.source.line(), log.source.column(),
-                    log.message);
-            oss.write(buffer.data(), buffer.size());
-            prevSource = log.source;
-            pendingMessages.fetch_sub(1);
-        }
-        messageQueue.unlock();
-        if (!oss.str().empty()) {
-            std::cout << oss.str();
-            file << oss.str();
-            oss.str("");
-            oss.clear();
-        }
-    }
-
-    Log log;
-    messageQueue.lock();
-    while (messageQueue.dequeueUnsafe(log)) {
-        oss << log.source.file_name() << ":" << log.source.line() << "\n"
-            << log.message << "\n";
-    }
-    messageQueue.unlock();
+            std::lock_guard lock(registryMtx);
+            active = buffers;
+        }
+        if (sinksChanged.exchange(false)) {
+            std::lock_guard lock(sinkMtx);
+            activeSinks = sinks;
+        }
+        if (channelsChanged.exchange(false)) syncChannels();
+        if (binaryLogChanged.exchange(false)) {
+            std::optional<std::filesystem::path> path;
+            {
+                std::lock_guard lock(mtx);
+                path = std::exchange(pendingBinaryLog, std::nullopt);
+            }
+            binaryLog.reset();
+            if (path && !path->empty()) {
+                try {
+                    binaryLog = std::make_unique<BinaryLogWriter>(*path);
+                }
+                catch (const std::exception& e) {
+                    std::format_to(std::back_inserter(buffer), "{} Logger: {}\n", g_errorTag, e.what());
+                }
+            }
+            prevSource = {};
+            for (ChannelOutput& output : outputs) output.prevSource = {};
+        }
+        // Channel sinks keep the output format while the binary log replaces the logger's own
+        const bool channelJson = outputFormat.load(std::memory_order_relaxed) == OutputFormat::JsonLines;
+        const bool json = !binaryLog && channelJson;
+        clock.update();
+        if (clock.conversion().anchorTicks != clockAnchorTicks.load(std::memory_order_relaxed)) publishClock(clock.conversion());
+        const int64_t passTime = clock.nowUnixNanos(); // for notices
+        if (passTime >= nextCVarPoll) {
+            nextCVarPoll = passTime + 100'000'000;
+            for (ChannelOutput& output : outputs) {
+                if (!output.channel) continue;
+                const int64_t verbosity = utl::CVarSystem::getInstance()->getIntCVar(output.channel->m_cvar);
+                if (verbosity == output.verbosity) continue;
+                output.verbosity = verbosity;
+                output.channel->setLogMask(VerbosityMask(static_cast<int>(verbosity)));
+            }
+        }
+        uint32_t threadIndex = 0;
+
+        auto emit = [&](LogRecord& record) {
+            const int64_t timestamp = clock.toUnixNanos(record.timestamp);
+            // Channels with sinks of their own get their own text, the rest is tagged with the name
+            if (record.channel >= outputs.size()) syncChannels();
+            ChannelOutput* output = record.channel < outputs.size() ? &outputs[record.channel] : nullptr;
+            const std::string_view channelName = output && output->channel ? output->channel->name() : std::string_view();
+            const bool own = output && !output->sinks.empty();
+            if (binaryLog) {
+                // The binary log replaces the logger's text, not the text of channels with sinks
+                binaryLog->write(record, timestamp, channelName);
+                if (!own) return;
+            }
+            std::vector<char>& out = own ? output->buffer : buffer;
+            std::source_location& previous = own ? output->prevSource : prevSource;
+            if (own ? channelJson : json) {
+                FormatJsonRecord(out, record, timestamp, threadIndex, channelName);
+                return;
+            }
+            FormatLogPrefix(out, record.type, record.source.file_name(), record.source.line(), record.source.column(), previous == record.source, timestamp);
+            if (!channelName.empty()) std::format_to(std::back_inserter(out), "[{}] ", channelName);
+            const size_t messageStart = out.size();
+            try {
+                FormatRecord(out, record);
+            }
+            catch (const std::exception& e) {
+                out.resize(messageStart);
+                std::format_to(std::back_inserter(out), "<format error: {}> {}", e.what(), record.format ? record.format : "");
+            }
+            out.push_back('\n');
+            previous = record.source;
+        };
+
+        size_t drained = 0;
+        for (auto& threadBuffer : active) {
+            const size_t drainedBefore = drained;
+            const bool retired = threadBuffer->retired.load(std::memory_order_acquire);
+            threadIndex = threadBuffer->threadIndex;
+            if (threadBuffer->spillPending.load(std::memory_order_acquire)) {
+                // Everything queued before the spill started is older than the spill
+                size_t olderEnd = 0;
+                {
+                    std::lock_guard lock(threadBuffer->spillMtx);
+                    olderEnd = threadBuffer->queue.produced();
+                    spilled.swap(threadBuffer->spill);
+                    threadBuffer->spillSize.store(0, std::memory_order_relaxed);
+                    threadBuffer->spillPending.store(false, std::memory_order_release);
+                }
+                drained += threadBuffer->queue.consumeUntil(olderEnd, emit);
+                for (auto& record : spilled) emit(*record);
+                drained += spilled.size();
+                spilled.clear();
+            }
+            drained += threadBuffer->queue.consumeAll(emit);
+            threadBuffer->passWritten = threadBuffer->written.load(std::memory_order_relaxed) + (drained - drainedBefore);
+            const uint64_t dropped = threadBuffer->dropped.load(std::memory_order_relaxed);
+            if (dropped != threadBuffer->reportedDrops) {
+                if (binaryLog) binaryLog->writeDropped(threadIndex, dropped - threadBuffer->reportedDrops);
+                else if (json) FormatJsonDropNotice(buffer, dropped - threadBuffer->reportedDrops, threadIndex, passTime);
+                else FormatDropNotice(buffer, dropped - threadBuffer->reportedDrops, threadIndex);
+                threadBuffer->reportedDrops = dropped;
+                prevSource = {};
+            }
+            if (retired) {
+                std::lock_guard lock(registryMtx);
+                std::erase(buffers, threadBuffer);
+                retiredBuffers.push_back(threadBuffer);
+                if (retiredBuffers.size() > keptRetiredBuffers) retiredBuffers.erase(retiredBuffers.begin());
+            }
+        }
+        if (suppressedPending.exchange(false, std::memory_order_acquire)) {
+            reportSuppressed(buffer, passTime, json);
+            prevSource = {};
+        }
+        if (binaryLog) binaryLog->flush();
+        writeSinks(activeSinks, buffer);
+        for (ChannelOutput& output : outputs) writeSinks(output.sinks, output.buffer);
+        for (auto& threadBuffer : active) threadBuffer->written.store(threadBuffer->passWritten, std::memory_order_release);
+        active.clear();
+        passesWritten.fetch_add(1, std::memory_order_release);
+        passesWritten.notify_all();
+        return drained;
+        };
+
+    while (running) {
+        if (drain() != 0) continue;
+
+        // Nothing came in during the last pass, sleep until a producer or flush wakes us.
+        // The fences pair with the ones in push: either the producer sees sleeping or we see its log
+        std::unique_lock lock(mtx);
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (isEmpty() && running) {
+            cv.wait_for(lock, std::chrono::milliseconds(100), [this] { return wakeRequested || !running; });
+        }
+        wakeRequested = false;
+        sleeping.store(false);
+    }
+    drain();
+    binaryLog.reset();
 }
 
 bool Debug::Logger::isEmpty()
 {
-    std::lock_guard<std::mutex> lock(mtx);
-    return messageQueue.isEmpty() && tempQueue.isEmpty() && (pendingMessages.load() == 0);
+    std::lock_guard lock(registryMtx);
+    return std::ranges::all_of(buffers, [](const auto& threadBuffer) {
+        return threadBuffer->queue.isEmpty() && !threadBuffer->spillPending.load(std::memory_order_acquire);
+        });
 }
 
-void Debug::Logger::addLog(const Log& log)
+Debug::Logger::ThreadBuffer& Debug::Logger::localBuffer()
 {
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        messageQueue.enqueue(log);
-        pendingMessages.fetch_add(1);
+    if (!localHandle.buffer) {
+        auto threadBuffer = std::make_shared<ThreadBuffer>();
+        threadBuffer->threadIndex = g_threadCounter.fetch_add(1);
+        {
+            std::lock_guard lock(registryMtx);
+            buffers.push_back(threadBuffer);
+        }
+        localHandle.buffer = std::move(threadBuffer);
+    }
+    return *localHandle.buffer;
+}
+
+// Producer side: next free slot of this thread's buffer, or what the backpressure policy gives
+// when it is full. nullptr means the log was dropped (and counted). Slots keep their text after
+// they are written for the flight recorder, it is released here when the slot comes around again
+Debug::LogRecord* Debug::Logger::reserveRecord(const Log::Type type)
+{
+    // Producers that passed isEnabled just before freeze
+    if (frozen.load(std::memory_order_acquire)) return nullptr;
+    ThreadBuffer& threadBuffer = localBuffer();
+    if (!threadBuffer.spillPending.load(std::memory_order_acquire)) {
+        if (LogRecord* record = threadBuffer.queue.reserve()) {
+            record->text.reset();
+            return record;
+        }
+    }
+    LogRecord* record = reserveFull(threadBuffer, type);
+    if (record) record->text.reset();
+    return record;
+}
+
+Debug::LogRecord* Debug::Logger::reserveFull(ThreadBuffer& threadBuffer, const Log::Type type)
+{
+    const bool severe = isSevere(type);
+    Backpressure policy = getBackpressure(type);
+    if (severe && (policy == Backpressure::DropNewest || policy == Backpressure::DropOldest)) policy = Backpressure::Spill;
+    // The logger thread can never wait on itself
+    if (policy == Backpressure::Block && std::this_thread::get_id() == thread.get_id()) policy = Backpressure::Spill;
+
+    if (policy == Backpressure::Block) {
+        for (int attempt = 0; running.load(std::memory_order_relaxed); ++attempt) {
+            if (!threadBuffer.spillPending.load(std::memory_order_acquire)) {
+                if (LogRecord* record = threadBuffer.queue.reserve()) return record;
+            }
+            wake();
+            if (attempt < 16) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        policy = Backpressure::Spill; // shutting down
+    }
+
+    if (policy == Backpressure::DropOldest && !threadBuffer.spillPending.load(std::memory_order_acquire)) {
+        LogRecord* record = threadBuffer.queue.reserve();
+        if (record) return record;
+        // Severe records are never evicted, the new one is dropped instead. evictOldest also succeeds
+        // when the logger made room in the meantime, only count what was really evicted
+        bool evicted = false;
+        if (threadBuffer.queue.evictOldest([&](const LogRecord& oldest) { return evicted = !isSevere(oldest.type); }) && (record = threadBuffer.queue.reserve())) {
+            if (evicted) {
+                countDrop(threadBuffer.dropped, droppedTotal);
+                threadBuffer.evicted.store(threadBuffer.evicted.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+            return record;
+        }
+    }
+
+    if (policy == Backpressure::Spill && (severe || threadBuffer.spillSize.load(std::memory_order_relaxed) < maxSpillRecords)) {
+        threadBuffer.pendingSpill = std::make_unique<LogRecord>();
+        return threadBuffer.pendingSpill.get();
+    }
+
+    countDrop(threadBuffer.dropped, droppedTotal);
+    return nullptr;
+}
+
+void Debug::Logger::commitRecord()
+{
+    ThreadBuffer& threadBuffer = *localHandle.buffer;
+    if (threadBuffer.pendingSpill) {
+        std::lock_guard lock(threadBuffer.spillMtx);
+        threadBuffer.spill.push_back(std::move(threadBuffer.pendingSpill));
+        threadBuffer.spillSize.store(threadBuffer.spill.size(), std::memory_order_relaxed);
+        threadBuffer.spillPending.store(true, std::memory_order_release);
+    }
+    else {
+        threadBuffer.queue.publish();
+    }
+    threadBuffer.committed.store(threadBuffer.committed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) wake();
+}
+
+bool Debug::Logger::addLog(const Log& log)
+{
+    return addLog(Log(log));
+}
+
+bool Debug::Logger::addLog(Log&& log)
+{
+    if (!isEnabled(log.type) || !admit(log.type, log.source)) return false;
+    LogRecord* record = reserveRecord(log.type);
+    if (!record) return false;
+    record->source = log.source;
+    record->type = log.type;
+    record->channel = 0;
+    record->timestamp = utl::TscClock::ticks();
+    SetRecordText(*record, std::move(log.message));
+    commitRecord();
+    return true;
+}
+
+// Producer side: false when the call site is over its rate limit, the log is only counted
+bool Debug::Logger::admit(const Log::Type type, const std::source_location& source)
+{
+    const uint32_t burst = rateBurst.load(std::memory_order_relaxed);
+    if (burst == 0 || isSevere(type)) return true;
+
+    CallSite& site = callSites->find(type, source);
+    const int64_t now = coarseNow();
+    const int64_t interval = 1'000'000'000 / std::max<uint32_t>(ratePerSecond.load(std::memory_order_relaxed), 1);
+    if (site.tryAcquire(now, interval, interval * (burst - 1))) return true;
+
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    if (!suppressedPending.load(std::memory_order_relaxed)) suppressedPending.store(true, std::memory_order_release);
+    return false;
+}
+
+// Logger thread: one "repeated N times" line per call site suppressed since the last pass
+void Debug::Logger::reportSuppressed(std::vector<char>& buffer, const int64_t timestamp, const bool json)
+{
+    std::lock_guard lock(callSites->mtx);
+    for (CallSite& site : callSites->sites) {
+        const uint64_t count = site.suppressed.exchange(0, std::memory_order_relaxed);
+        if (count == 0) continue;
+        site.reported += count;
+        if (binaryLog) binaryLog->writeSuppressed(site.type, site.file, site.line, site.column, count, timestamp);
+        else if (json) FormatJsonSuppressedNotice(buffer, site.type, site.file, site.line, site.column, count, timestamp);
+        else FormatSuppressedNotice(buffer, site.type, site.file, site.line, site.column, count, timestamp);
+    }
+}
 
+void Debug::Logger::wake()
+{
+    {
+        std::lock_guard lock(mtx);
+        wakeRequested = true;
     }
     cv.notify_one();
 }
 
-void Debug::Logger::dump()
+void Debug::Logger::publishClock(const utl::TscConversion& conversion) noexcept
+{
+    const uint32_t seq = clockSeq.load(std::memory_order_relaxed);
+    clockSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    clockAnchorTicks.store(conversion.anchorTicks, std::memory_order_relaxed);
+    clockAnchorNanos.store(conversion.anchorNanos, std::memory_order_relaxed);
+    clockNanosPerTick.store(conversion.nanosPerTick, std::memory_order_relaxed);
+    clockSeq.store(seq + 2, std::memory_order_release);
+}
+
+utl::TscConversion Debug::Logger::readClock() const noexcept
 {
-    std::ofstream dump{ "log.txt" };
+    utl::TscConversion conversion;
+    // Bounded, a crash handler may have interrupted the writer halfway
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        const uint32_t seq = clockSeq.load(std::memory_order_acquire);
+        conversion.anchorTicks = clockAnchorTicks.load(std::memory_order_relaxed);
+        conversion.anchorNanos = clockAnchorNanos.load(std::memory_order_relaxed);
+        conversion.nanosPerTick = clockNanosPerTick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq % 2 == 0 && clockSeq.load(std::memory_order_relaxed) == seq) break;
+    }
+    return conversion;
+}
+
+// Async-signal-safe: no allocation, only try_lock, output through write(2)
+bool Debug::Logger::dumpFlightRecorder(const int fd) noexcept
+{
+    constexpr size_t maxThreads = 256;
+    // Over the queue of a thread, or over its spill list when spill is set
+    struct Cursor
+    {
+        const ThreadBuffer* buffer;
+        const std::unique_ptr<LogRecord>* spill;
+        size_t next;
+        size_t end;
+
+        const LogRecord& record() const noexcept { return spill ? *spill[next] : buffer->queue.at(next); }
+    };
+    Cursor cursors[maxThreads * 2];
+    size_t cursorCount = 0;
+    size_t threadCount = 0;
+    ThreadBuffer* spillLocked[maxThreads];
+    size_t spillLockedCount = 0;
+
+    // A crashing thread may hold the registry lock, go on without it after a while
+    bool locked = false;
+    for (int attempt = 0; attempt < 10000 && !locked; ++attempt) locked = registryMtx.try_lock();
+    for (const auto* list : { &retiredBuffers, &buffers }) {
+        for (const auto& threadBuffer : *list) {
+            if (threadCount++ == maxThreads) break;
+            const size_t end = threadBuffer->queue.produced();
+            cursors[cursorCount++] = { threadBuffer.get(), nullptr, end > threadBufferCapacity ? end - threadBufferCapacity : 0, end };
+            // Records spilled but not written yet, skipped when the spill lock is held
+            bool spillLock = false;
+            for (int attempt = 0; attempt < 100 && !spillLock; ++attempt) spillLock = threadBuffer->spillMtx.try_lock();
+            if (!spillLock) continue;
+            spillLocked[spillLockedCount++] = threadBuffer.get();
+            if (!threadBuffer->spill.empty()) cursors[cursorCount++] = { threadBuffer.get(), threadBuffer->spill.data(), 0, threadBuffer->spill.size() };
+        }
+    }
+
+    const utl::TscConversion clock = readClock();
+    BinaryLogDumpWriter writer(fd, clock.toUnixNanos(utl::TscClock::ticks()));
+    // Channel names are optional, the reader falls back to the id
+    if (channelMtx.try_lock()) {
+        for (const auto& channel : channels) writer.writeChannel(channel->id(), channel->name());
+        channelMtx.unlock();
+    }
+    while (true) {
+        Cursor* oldest = nullptr;
+        for (size_t i = 0; i < cursorCount; ++i) {
+            Cursor& cursor = cursors[i];
+            if (cursor.next == cursor.end) continue;
+            if (!oldest || cursor.record().timestamp < oldest->record().timestamp) oldest = &cursor;
+        }
+        if (!oldest) break;
+        const LogRecord& record = oldest->record();
+        ++oldest->next;
+        if (record.format || record.text) writer.write(record, clock.toUnixNanos(record.timestamp));
+    }
+    for (size_t i = 0; i < spillLockedCount; ++i) spillLocked[i]->spillMtx.unlock();
+    if (locked) registryMtx.unlock();
+    return writer.flush();
+}
+
+void Debug::Logger::dump(const std::filesystem::path& path)
+{
+    FileLogSink file(path, false);
+    if (!dumpFlightRecorder(file.fd())) throw std::runtime_error("Logger: cannot write flight recorder to " + path.string());
+}
+
+void Debug::Logger::flush(const FlushLevel level)
+{
+    if (std::this_thread::get_id() == thread.get_id()) return;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Sequence every buffer has to reach: whatever was committed to it so far. Not thread_local,
+    // the destructor flushes after the thread locals of the main thread are gone
+    std::vector<std::pair<std::shared_ptr<ThreadBuffer>, uint64_t>> targets;
+    auto reached = [](const auto& target) {
+        return target.first->written.load(std::memory_order_acquire) + target.first->evicted.load(std::memory_order_acquire) >= target.second;
+        };
+    {
+        std::lock_guard lock(registryMtx);
+        for (const auto& threadBuffer : buffers) targets.emplace_back(threadBuffer, threadBuffer->committed.load(std::memory_order_relaxed));
+    }
+    std::erase_if(targets, reached);
+    if (!targets.empty()) wake();
+    while (!targets.empty() && running.load()) {
+        const uint32_t pass = passesWritten.load(std::memory_order_acquire);
+        std::erase_if(targets, reached);
+        if (!targets.empty()) passesWritten.wait(pass, std::memory_order_acquire);
+    }
 
+    std::vector<std::shared_ptr<LogSink>> toFlush;
+    {
+        std::lock_guard lock(sinkMtx);
+        toFlush = sinks;
+    }
+    {
+        std::lock_guard lock(channelMtx);
+        for (const auto& channel : channels) {
+            std::lock_guard sinkLock(channel->m_sinkMutex);
+            toFlush.insert(toFlush.end(), channel->m_sinks.begin(), channel->m_sinks.end());
+        }
+    }
+    for (auto& sink : toFlush) {
+        if (level == FlushLevel::Synced) sink->sync();
+        else sink->flush();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard lock(flushStatsMtx);
+    flushTimes.update(static_cast<uint64_t>(elapsed));
 }
 
-void Debug::Logger::flush()
+utl::TimerStats Debug::Logger::flushStats() const
 {
-    while (!isEmpty()) { std::this_thread::yield(); }
+    std::lock_guard lock(flushStatsMtx);
+    return flushTimes;
 }
 
 void Debug::Logger::waitForReady()
@@ -189,4 +774,166 @@ void Debug::Logger::waitForReady() const
     readyFuture.wait();
 }
 
-void Debug::Logger::setLogMask(Log::TypeFlags mask) { logMask = mask; }
+void Debug::Logger::setLogMask(Log::TypeFlags mask) { logMask.store(mask.getMask(), std::memory_order_relaxed); }
+
+uint64_t Debug::Logger::droppedCount() const noexcept { return droppedTotal.load(std::memory_order_relaxed); }
+
+void Debug::Logger::setBackpressure(const Backpressure policy)
+{
+    for (auto& entry : backpressure) entry.store(policy, std::memory_order_relaxed);
+}
+
+void Debug::Logger::setBackpressure(const Log::TypeFlags types, const Backpressure policy)
+{
+    for (size_t i = 0; i < backpressure.size(); ++i) {
+        if (types.getMask() & (1 << i)) backpressure[i].store(policy, std::memory_order_relaxed);
+    }
+}
+
+Debug::Logger::Backpressure Debug::Logger::getBackpressure(const Log::Type type) const noexcept
+{
+    return backpressure[typeIndex(type)].load(std::memory_order_relaxed);
+}
+
+void Debug::Logger::setRateLimit(const RateLimit limit)
+{
+    ratePerSecond.store(limit.perSecond, std::memory_order_relaxed);
+    rateBurst.store(limit.burst, std::memory_order_relaxed);
+}
+
+Debug::Logger::RateLimit Debug::Logger::getRateLimit() const noexcept
+{
+    return { rateBurst.load(std::memory_order_relaxed), ratePerSecond.load(std::memory_order_relaxed) };
+}
+
+uint64_t Debug::Logger::suppressedCount() const noexcept
+{
+    std::lock_guard lock(callSites->mtx);
+    uint64_t total = 0;
+    for (const CallSite& site : callSites->sites) total += site.reported + site.suppressed.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Debug::Logger::addSink(std::shared_ptr<LogSink> sink)
+{
+    if (!sink) return;
+    std::lock_guard lock(sinkMtx);
+    sinks.push_back(std::move(sink));
+    sinksChanged.store(true);
+}
+
+void Debug::Logger::removeSink(const std::shared_ptr<LogSink>& sink)
+{
+    std::lock_guard lock(sinkMtx);
+    std::erase(sinks, sink);
+    sinksChanged.store(true);
+}
+
+void Debug::Logger::clearSinks()
+{
+    std::lock_guard lock(sinkMtx);
+    sinks.clear();
+    sinksChanged.store(true);
+}
+
+Debug::LogChannel& Debug::Logger::channel(const utl::StringHash name)
+{
+    std::lock_guard lock(channelMtx);
+    if (const auto it = channelIndex.find(name.hash); it != channelIndex.end()) return *it->second;
+    if (name.strView.empty()) throw std::invalid_argument("Logger: unknown log channel");
+    if (channels.size() == maxChannels) throw std::runtime_error("Logger: too many log channels");
+    auto& channel = channels.emplace_back(new LogChannel(*this, std::string(name.strView), static_cast<uint8_t>(channels.size() + 1)));
+    channelIndex.emplace(name.hash, channel.get());
+    channelsChanged.store(true);
+    return *channel;
+}
+
+void Debug::Logger::setBinaryLog(std::filesystem::path path)
+{
+    {
+        std::lock_guard lock(mtx);
+        pendingBinaryLog = std::move(path);
+    }
+    binaryLogChanged.store(true);
+    wake();
+}
+
+void Debug::FormatLogPrefix(std::vector<char>& out, const Log::Type type, const std::string_view file, const uint32_t line, const uint32_t column, const bool continuation, const int64_t timestamp)
+{
+    if (!continuation)
+        std::format_to(std::back_inserter(out), "{} {}({},{}):\n", StreamLogType(type), file, line, column);
+
+    // "|> hh:mm:ss.uuuuuu ", written by hand, this runs for every message
+    constexpr int64_t microsPerDay = 86'400'000'000;
+    int64_t micros = (timestamp / 1000) % microsPerDay;
+    if (micros < 0) micros += microsPerDay;
+    char text[19] = { '|', '>', ' ', '0', '0', ':', '0', '0', ':', '0', '0', '.', '0', '0', '0', '0', '0', '0', ' ' };
+    for (int i = 17; i >= 12; --i, micros /= 10) text[i] = static_cast<char>('0' + micros % 10);
+    for (int i = 10; i >= 3; i -= 3) {
+        const int64_t limit = i == 4 ? 24 : 60;
+        const int64_t part = micros % limit;
+        micros /= limit;
+        text[i - 1] = static_cast<char>('0' + part / 10);
+        text[i] = static_cast<char>('0' + part % 10);
+    }
+    out.insert(out.end(), std::begin(text), std::end(text));
+}
+
+void Debug::FormatDropNotice(std::vector<char>& out, const uint64_t count, const uint32_t threadIndex)
+{
+    std::format_to(std::back_inserter(out), "{} Logger dropped {} logs from thread {}\n", g_warningTag, count, threadIndex);
+}
+
+void Debug::FormatSuppressedNotice(std::vector<char>& out, const Log::Type type, const std::string_view file, const uint32_t line, const uint32_t column, const uint64_t count, const int64_t timestamp)
+{
+    FormatLogPrefix(out, type, file, line, column, false, timestamp);
+    std::format_to(std::back_inserter(out), "message repeated {} more times (rate limited)\n", count);
+}
+
+
+Debug::LogChannel::LogChannel(Logger& logger, std::string name, const uint8_t id)
+    : m_logger(logger), m_name(std::move(name)), m_cvarName("log." + m_name), m_cvar(m_cvarName), m_id(id)
+{
+    // A CVar set before the channel existed (from a config file) wins over the default
+    utl::CVarSystem* cvars = utl::CVarSystem::getInstance();
+    int64_t verbosity = 0;
+    if (cvars->getCVarParameter(m_cvar)) verbosity = cvars->getIntCVar(m_cvar);
+    else cvars->createIntCVar(m_cvarName, 0, {}, "Lowest level the log channel writes: 0 trace, 1 info, 2 warning, 3 error, 4 fatal error");
+    m_mask.store(VerbosityMask(static_cast<int>(verbosity)).getMask(), std::memory_order_relaxed);
+    m_verbosity.store(verbosity, std::memory_order_relaxed);
+}
+
+void Debug::LogChannel::setVerbosity(const int level)
+{
+    setLogMask(VerbosityMask(level));
+    m_verbosity.store(level, std::memory_order_relaxed);
+    utl::CVarSystem::getInstance()->setIntCVar(m_cvar, level);
+}
+
+void Debug::LogChannel::addSink(std::shared_ptr<LogSink> sink)
+{
+    if (!sink) return;
+    std::lock_guard lock(m_sinkMutex);
+    m_sinks.push_back(std::move(sink));
+    m_logger.channelsChanged.store(true);
+}
+
+void Debug::LogChannel::removeSink(const std::shared_ptr<LogSink>& sink)
+{
+    std::lock_guard lock(m_sinkMutex);
+    std::erase(m_sinks, sink);
+    m_logger.channelsChanged.store(true);
+}
+
+void Debug::LogChannel::clearSinks()
+{
+    std::lock_guard lock(m_sinkMutex);
+    m_sinks.clear();
+    m_logger.channelsChanged.store(true);
+}
+
+Debug::Log::TypeFlags Debug::VerbosityMask(const int level) noexcept
+{
+    const int clamped = std::clamp(level, 0, 4);
+    return Log::TypeFlags(g_allLogTypes.getMask() & ~((1u << clamped) - 1));
+}
@@ -0,0 +1,222 @@
+#include "MemUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    void touchPages(std::byte* ptr, size_t bytes) noexcept
+    {
+        const size_t page = utl::PageSize();
+        for (size_t offset = 0; offset < bytes; offset += page) {
+            reinterpret_cast<volatile std::byte*>(ptr)[offset] = std::byte{ 0 };
+        }
+    }
+#endif
+
+#ifdef __linux__
+    // PMD size the kernel uses for transparent huge pages, e.g. 2 MiB on x86-64 but 512 MiB on
+    // aarch64 with 64K pages. Falls back to the hugetlbfs default size, 0 if neither is known
+    size_t readHugePageSize() noexcept
+    {
+        size_t size = 0;
+        if (std::FILE* file = std::fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r")) {
+            if (std::fscanf(file, "%zu", &size) != 1) size = 0;
+            std::fclose(file);
+            if (size != 0) return size;
+        }
+        if (std::FILE* file = std::fopen("/proc/meminfo", "r")) {
+            char line[256];
+            while (std::fgets(line, sizeof(line), file)) {
+                size_t kb = 0;
+                if (std::sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) {
+                    size = kb * 1024;
+                    break;
+                }
+            }
+            std::fclose(file);
+        }
+        return size;
+    }
+#endif
+}
+
+size_t utl::PageSize() noexcept
+{
+    static const size_t pageSize = [] {
+#ifdef _WIN32
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+#else
+        const long size = sysconf(_SC_PAGESIZE);
+        return size > 0 ? static_cast<size_t>(size) : size_t(4096);
+#endif
+    }();
+    return pageSize;
+}
+
+size_t utl::HugePageSize() noexcept
+{
+#ifdef _WIN32
+    static const size_t hugePageSize = GetLargePageMinimum();
+    return hugePageSize;
+#elif defined(__linux__)
+    static const size_t hugePageSize = readHugePageSize();
+    return hugePageSize;
+#else
+    return 0;
+#endif
+}
+
+void* utl::AlignedAlloc(const size_t bytes, size_t alignment)
+{
+    alignment = std::max(alignment, sizeof(void*));
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(bytes ? bytes : 1, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bytes ? bytes : 1) != 0) ptr = nullptr;
+#endif
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void utl::AlignedFree(void* ptr) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+size_t utl::MapRegionSize(const size_t bytes, const MapFlags flags) noexcept
+{
+    const size_t hugePage = HugePageSize();
+    const bool huge = hugePage != 0 && (flags.has(MapFlagBits::hugePages) || flags.has(MapFlagBits::explicitHugePages));
+    return AlignUp(bytes ? bytes : 1, huge ? hugePage : PageSize());
+}
+
+void* utl::MapRegion(const size_t bytes, const MapFlags flags) noexcept
+{
+    const size_t size = MapRegionSize(bytes, flags);
+#ifdef _WIN32
+    void* ptr = nullptr;
+    if (flags.has(MapFlagBits::explicitHugePages) && HugePageSize() != 0) {
+        // Needs SeLockMemoryPrivilege, quietly fall back to normal pages without it
+        ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+    if (!ptr) {
+        ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (ptr && flags.has(MapFlagBits::populate)) {
+        touchPages(static_cast<std::byte*>(ptr), size);
+    }
+    return ptr;
+#else
+    int mmapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if (flags.has(MapFlagBits::populate)) mmapFlags |= MAP_POPULATE;
+#endif
+
+#ifdef MAP_HUGETLB
+    if (flags.has(MapFlagBits::explicitHugePages)) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, mmapFlags | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) return ptr;
+    }
+#endif
+
+    const bool huge = flags.has(MapFlagBits::hugePages) || flags.has(MapFlagBits::explicitHugePages);
+    const size_t hugePage = HugePageSize();
+    if (!huge || hugePage == 0) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, mmapFlags, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    // Over-map and trim so the region starts on a huge page boundary, otherwise THP cannot back it.
+    // Populate only after the advice so the first faults already get huge pages
+    const size_t padded = size + hugePage;
+    void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    auto* begin = static_cast<std::byte*>(raw);
+    auto* aligned = reinterpret_cast<std::byte*>(AlignUp(reinterpret_cast<uintptr_t>(begin), hugePage));
+    if (aligned != begin) munmap(begin, static_cast<size_t>(aligned - begin));
+    const size_t tail = static_cast<size_t>((begin + padded) - (aligned + size));
+    if (tail) munmap(aligned + size, tail);
+
+    AdviseHugePages(aligned, size);
+#ifdef MADV_POPULATE_WRITE
+    if (flags.has(MapFlagBits::populate) && madvise(aligned, size, MADV_POPULATE_WRITE) == 0) return aligned;
+#endif
+    if (flags.has(MapFlagBits::populate)) {
+        const size_t page = PageSize();
+        for (size_t offset = 0; offset < size; offset += page) {
+            reinterpret_cast<volatile std::byte*>(aligned)[offset] = std::byte{ 0 };
+        }
+    }
+    return aligned;
+#endif
+}
+
+void utl::UnmapRegion(void* ptr, const size_t bytes, const MapFlags flags) noexcept
+{
+    if (!ptr) return;
+#ifdef _WIN32
+    (void)bytes;
+    (void)flags;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, MapRegionSize(bytes, flags));
+#endif
+}
+
+bool utl::AdviseHugePages([[maybe_unused]] void* ptr, [[maybe_unused]] const size_t bytes) noexcept
+{
+#if defined(MADV_HUGEPAGE)
+    return madvise(ptr, bytes, MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+}
+
+bool utl::AdviseDontNeed(void* ptr, const size_t bytes) noexcept
+{
+#ifdef _WIN32
+    // Decommit and recommit so the range reads back as zeros, matching MADV_DONTNEED
+    return VirtualFree(ptr, bytes, MEM_DECOMMIT) && VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return madvise(ptr, bytes, MADV_DONTNEED) == 0;
+#endif
+}
+
+
+utl::HugeBuffer::HugeBuffer(const size_t bytes, const MapFlags flags)
+    : m_size(bytes), m_mappedSize(MapRegionSize(bytes, flags)), m_flags(flags)
+{
+    m_data = static_cast<std::byte*>(MapRegion(bytes, flags));
+    if (!m_data) throw std::bad_alloc();
+}
+
+void utl::HugeBuffer::reset() noexcept
+{
+    UnmapRegion(m_data, m_size, m_flags);
+    m_data = nullptr;
+    m_size = 0;
+    m_mappedSize = 0;
+}
+
+void utl::HugeBuffer::discard() noexcept
+{
+    if (m_data) AdviseDontNeed(m_data, m_mappedSize);
+}
@@ -0,0 +1,190 @@
+#include "SlabAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    constexpr size_t classCount = utl::SlabAllocator::classCount;
+
+    constexpr size_t batchSize(size_t index) noexcept {
+        return std::clamp<size_t>(8 * 1024 / utl::SlabAllocator::classSize(index), 4, 64);
+    }
+
+    // Thread caches hold up to two batches per class as a stack of pointers, one flat array for all
+    // classes. Freed objects are never written to, so moving a batch is a copy of pointers and
+    // never walks cold object memory
+    constexpr size_t cacheCapacity(size_t index) noexcept { return 2 * batchSize(index); }
+
+    constexpr auto cacheOffsets = [] {
+        std::array<size_t, classCount + 1> offsets{};
+        for (size_t i = 0; i < classCount; ++i) offsets[i + 1] = offsets[i] + cacheCapacity(i);
+        return offsets;
+    }();
+
+    // Per-class stack shared by all threads. Its capacity always covers every object carved for the
+    // class, so pushing back never allocates
+    struct alignas(64) CentralList {
+        std::mutex mtx;
+        std::vector<void*> objects;
+    };
+
+    // Never destroyed, static destructors and threads still running at exit may free objects
+    std::array<CentralList, classCount>& centralLists() {
+        static auto* lists = new std::array<CentralList, classCount>();
+        return *lists;
+    }
+    std::atomic_size_t g_slabBytes{ 0 };
+    std::atomic_size_t g_largeAllocations{ 0 };
+
+    // Carve a fresh slab into central.objects, the caller holds the lock
+    void carveSlab(size_t index, CentralList& central) {
+        const size_t size = utl::SlabAllocator::classSize(index);
+        const size_t count = utl::SlabAllocator::slabSize / size;
+        central.objects.reserve(central.objects.capacity() + count);
+        auto* slab = static_cast<std::byte*>(::operator new(utl::SlabAllocator::slabSize, std::align_val_t{ 64 }));
+        g_slabBytes.fetch_add(utl::SlabAllocator::slabSize, std::memory_order_relaxed);
+        // Popped from the back, so pushed in reverse to hand out ascending addresses
+        for (size_t i = count; i-- > 0;) central.objects.push_back(slab + i * size);
+    }
+
+    enum class CacheState : uint8_t {
+        Fresh,      // not used by this thread yet
+        Active,
+        Exited      // flushed at thread exit, later calls go straight to the central lists
+    };
+
+    // Trivially destructible and constant initialized, so it stays usable from thread_local
+    // destructors that run after the exit flush
+    struct ThreadCache {
+        CacheState state;
+        std::array<uint32_t, classCount> counts;
+        std::array<void*, cacheOffsets[classCount]> slots;
+
+        void** stack(size_t index) noexcept { return slots.data() + cacheOffsets[index]; }
+
+        // Take one batch from the central list, carving a new slab when it runs short
+        void refill(size_t index) {
+            auto& central = centralLists()[index];
+            std::lock_guard lock(central.mtx);
+            const size_t wanted = batchSize(index);
+            if (central.objects.size() < wanted) carveSlab(index, central);
+            const size_t taken = std::min(wanted, central.objects.size());
+            std::memcpy(stack(index) + counts[index], central.objects.data() + central.objects.size() - taken, taken * sizeof(void*));
+            central.objects.resize(central.objects.size() - taken);
+            counts[index] += static_cast<uint32_t>(taken);
+        }
+
+        // Hand the count coldest objects (the bottom of the stack) back to the central list
+        void release(size_t index, size_t count) noexcept {
+            void** objects = stack(index);
+            {
+                auto& central = centralLists()[index];
+                std::lock_guard lock(central.mtx);
+                central.objects.insert(central.objects.end(), objects, objects + count);
+            }
+            counts[index] -= static_cast<uint32_t>(count);
+            std::memmove(objects, objects + count, counts[index] * sizeof(void*));
+        }
+    };
+
+    constinit thread_local ThreadCache t_cache{};
+
+    // Gives the cache back when the thread exits. Constructed on a thread's first slab call
+    struct ThreadCacheFlush {
+        ~ThreadCacheFlush() {
+            for (size_t i = 0; i < classCount; ++i) t_cache.release(i, t_cache.counts[i]);
+            t_cache.state = CacheState::Exited;
+        }
+    };
+    thread_local ThreadCacheFlush t_flush;
+
+    // Returns false once the thread has exited
+    bool activate(ThreadCache& cache) noexcept {
+        if (cache.state == CacheState::Fresh) {
+            [[maybe_unused]] volatile auto* flush = &t_flush;
+            cache.state = CacheState::Active;
+        }
+        return cache.state == CacheState::Active;
+    }
+
+    inline bool isSmall(size_t bytes, size_t alignment) noexcept {
+        return bytes <= utl::SlabAllocator::maxSmallSize && alignment <= alignof(std::max_align_t);
+    }
+
+    // Class sizes above 8 are multiples of 16, so rounding up to the alignment keeps objects aligned
+    inline size_t classFor(size_t bytes, size_t alignment) noexcept {
+        return utl::SlabAllocator::sizeClass(std::max(bytes, alignment));
+    }
+
+    void* allocateSlow(ThreadCache& cache, size_t index) {
+        if (!activate(cache)) {
+            auto& central = centralLists()[index];
+            std::lock_guard lock(central.mtx);
+            if (central.objects.empty()) carveSlab(index, central);
+            void* object = central.objects.back();
+            central.objects.pop_back();
+            return object;
+        }
+        if (cache.counts[index] == 0) cache.refill(index);
+        return cache.stack(index)[--cache.counts[index]];
+    }
+
+    void deallocateSlow(ThreadCache& cache, size_t index, void* ptr) noexcept {
+        if (!activate(cache)) {
+            auto& central = centralLists()[index];
+            std::lock_guard lock(central.mtx);
+            central.objects.push_back(ptr);
+            return;
+        }
+        if (cache.counts[index] == cacheCapacity(index)) cache.release(index, batchSize(index));
+        cache.stack(index)[cache.counts[index]++] = ptr;
+    }
+
+}
+
+
+void* utl::SlabAllocator::allocate(const size_t bytes, const size_t alignment)
+{
+    if (!isSmall(bytes, alignment)) {
+        g_largeAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(bytes, std::align_val_t{ alignment });
+    }
+
+    const size_t index = classFor(bytes, alignment);
+    auto& cache = t_cache;
+    if (cache.state == CacheState::Active && cache.counts[index] != 0) {
+        return cache.stack(index)[--cache.counts[index]];
+    }
+    return allocateSlow(cache, index);
+}
+
+void utl::SlabAllocator::deallocate(void* ptr, const size_t bytes, const size_t alignment) noexcept
+{
+    if (!ptr) return;
+    if (!isSmall(bytes, alignment)) {
+        ::operator delete(ptr, std::align_val_t{ alignment });
+        return;
+    }
+
+    const size_t index = classFor(bytes, alignment);
+    auto& cache = t_cache;
+    if (cache.state == CacheState::Active && cache.counts[index] != cacheCapacity(index)) {
+        cache.stack(index)[cache.counts[index]++] = ptr;
+        return;
+    }
+    deallocateSlow(cache, index, ptr);
+}
+
+utl::SlabAllocator::Stats utl::SlabAllocator::stats() noexcept
+{
+    return { g_slabBytes.load(std::memory_order_relaxed), g_largeAllocations.load(std::memory_order_relaxed) };
+}
+
+std::pmr::memory_resource* utl::SlabAllocator::resource() noexcept
+{
+    static SlabResource resource;
+    return &resource;
+}
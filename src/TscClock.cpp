@@ -0,0 +1,59 @@
+#include "TscClock.h"
+
+namespace {
+    int64_t systemNanos() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+
+utl::TscCalibration::TscCalibration(const std::chrono::nanoseconds interval) : m_interval(interval)
+{
+    m_base = sample();
+    m_conversion.anchorTicks = m_base.ticks;
+    m_conversion.anchorNanos = m_base.nanos;
+    // A short spin for a usable first rate, update() refines it from there
+    while (systemNanos() - m_base.nanos < 1'000'000) {}
+    recalibrate();
+}
+
+// Pair a tick count with the system clock. The system clock read is bracketed by two tick reads
+// and the tightest of a few attempts wins, so a preemption in the middle does not skew the pair
+utl::TscCalibration::Sample utl::TscCalibration::sample() noexcept
+{
+    Sample best{};
+    uint64_t bestWindow = UINT64_MAX;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint64_t before = TscClock::ticks();
+        const int64_t nanos = systemNanos();
+        const uint64_t after = TscClock::ticks();
+        if (after - before < bestWindow) {
+            bestWindow = after - before;
+            best = { before + (after - before) / 2, nanos };
+        }
+    }
+    return best;
+}
+
+void utl::TscCalibration::recalibrate()
+{
+    const Sample now = sample();
+    if (now.ticks != m_base.ticks && now.nanos > m_base.nanos) {
+        const double rate = static_cast<double>(now.nanos - m_base.nanos) / static_cast<double>(now.ticks - m_base.ticks);
+        // A rate far off the previous one means the system clock was stepped: measure from here
+        // on and keep the old rate, the anchor below already absorbs the step
+        if (m_base.ticks != m_conversion.anchorTicks && (rate < m_conversion.nanosPerTick * 0.99 || rate > m_conversion.nanosPerTick * 1.01)) m_base = now;
+        else m_conversion.nanosPerTick = rate;
+    }
+    else {
+        m_base = now;
+    }
+    m_conversion.anchorTicks = now.ticks;
+    m_conversion.anchorNanos = now.nanos;
+}
+
+void utl::TscCalibration::update()
+{
+    if (static_cast<double>(TscClock::ticks() - m_conversion.anchorTicks) * m_conversion.nanosPerTick >= static_cast<double>(m_interval.count())) recalibrate();
+}
@@ -0,0 +1,34 @@
+#include "ByteRing.h"
+#include "Check.h"
+#include <array>
+#include <cstddef>
+#include <utility>
+
+int main()
+{
+    const std::array<std::byte, 3> data{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 3 } };
+    std::array<std::byte, 3> out{};
+
+    utl::ByteRing ring(1);
+    CHECK(ring.valid() && ring.capacity() > 0);
+    CHECK(ring.write(data));
+
+    // The move takes the storage and the queued bytes along
+    utl::ByteRing moved(std::move(ring));
+    CHECK(moved.valid() && moved.size() == data.size());
+    CHECK(moved.read(out) && out == data);
+
+    // The moved-from ring has nothing to hand out
+    CHECK(!ring.valid() && ring.capacity() == 0 && ring.isEmpty());
+    CHECK(ring.reserve(1).empty());
+    CHECK(ring.writable().empty());
+    CHECK(ring.peek().empty());
+    CHECK(!ring.write(data));
+    CHECK(!ring.read(out));
+
+    // and works again once assigned to
+    ring = std::move(moved);
+    CHECK(ring.valid() && !moved.valid());
+    CHECK(ring.write(data) && ring.read(out) && out == data);
+    return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal assertion for the test executables: reports the failing expression and exits non-zero,
+// also in release builds
+#define CHECK(expr) \
+    do { if (!(expr)) { std::fprintf(stderr, "%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #expr); std::exit(1); } } while (0)
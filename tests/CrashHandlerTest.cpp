@@ -0,0 +1,59 @@
+#include "BinaryLog.h"
+#include "Check.h"
+#include "Debug.h"
+#include "FlightRecorder.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+int main()
+{
+#ifndef _WIN32
+    // The crash happens in a child, forked before the logger thread exists
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("myutils-crash-test-" + std::to_string(getpid()) + ".bin");
+    const pid_t child = fork();
+    CHECK(child >= 0);
+    if (child == 0) {
+        Debug::Init();
+        Debug::Logger& logger = Debug::Logger::Instance();
+        logger.clearSinks();
+        Debug::InstallCrashHandlers(path);
+        Debug::Info("before crash {}", 1);
+        Debug::Warning(Debug::Channel("net"), "socket {} closed", 9);
+        std::abort();
+    }
+    int status = 0;
+    CHECK(waitpid(child, &status, 0) == child);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+    std::ifstream in(path, std::ios::binary);
+    CHECK(in);
+    Debug::BinaryLogReader reader(in);
+    std::vector<char> out;
+    while (reader.next(out)) {}
+    const std::string decoded(out.data(), out.size());
+    CHECK(decoded.find("before crash 1") != std::string::npos);
+    CHECK(decoded.find("[net] socket 9 closed") != std::string::npos);
+    in.close();
+    std::filesystem::remove(path);
+#endif
+
+    // Freezing closes the logger and every channel
+    Debug::Logger& logger = Debug::Logger::Instance();
+    logger.clearSinks();
+    Debug::LogChannel& audio = Debug::Channel("audio");
+    CHECK(logger.isEnabled(Debug::Log::Type::Info) && audio.isEnabled(Debug::Log::Type::Info));
+    logger.freeze();
+    CHECK(!logger.isEnabled(Debug::Log::Type::Error) && !audio.isEnabled(Debug::Log::Type::Error));
+    CHECK(!logger.log(audio, Debug::Log::Type::Error, "dropped {}", std::source_location::current(), 1));
+    CHECK(!logger.addLog(Debug::Log("dropped", Debug::Log::Type::Error)));
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "BinaryLog.h"
+#include "Check.h"
+#include "Debug.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Holds the logger thread inside its first write until released
+    class GateSink : public Debug::LogSink
+    {
+    public:
+        std::atomic_bool entered = false;
+        std::atomic_bool open = false;
+
+        void write(std::span<const std::string_view>) override {
+            entered.store(true);
+            while (!open.load()) std::this_thread::yield();
+        }
+    };
+}
+
+int main()
+{
+    Debug::Init();
+    Debug::Logger& logger = Debug::Logger::Instance();
+    logger.setBackpressure(Debug::Logger::Backpressure::Spill);
+    logger.clearSinks();
+    const auto gate = std::make_shared<GateSink>();
+    logger.addSink(gate);
+
+    Debug::Info("blocking");
+    while (!gate->entered.load()) std::this_thread::yield();
+
+    // The queue fills up and the rest goes to the spill list, which only the dump can see now
+    constexpr size_t count = Debug::Logger::threadBufferCapacity + 100;
+    for (size_t i = 0; i < count; ++i) Debug::Info("record {}", i);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "myutils-flight-test.bin";
+    {
+        Debug::FileLogSink file(path, false);
+        CHECK(logger.dumpFlightRecorder(file.fd()));
+    }
+    gate->open.store(true);
+    logger.flush();
+    logger.clearSinks();
+
+    std::ifstream in(path, std::ios::binary);
+    Debug::BinaryLogReader reader(in);
+    std::vector<char> out;
+    while (reader.next(out)) {}
+    const std::string decoded(out.data(), out.size());
+    CHECK(decoded.find("record 0\n") != std::string::npos);
+    CHECK(decoded.find("record " + std::to_string(count - 1) + "\n") != std::string::npos);
+
+    in.close();
+    std::filesystem::remove(path);
+    return 0;
+}
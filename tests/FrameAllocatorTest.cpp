@@ -0,0 +1,22 @@
+#include "Check.h"
+#include "FrameAllocator.h"
+#include <cstdint>
+
+int main()
+{
+    utl::exp::Clock clock(0, 0);
+    utl::FrameAllocator<> frame(clock, 64 * 1024);
+
+    // Over-aligned requests must align the address, not just the offset into the buffer
+    for (const size_t alignment : { size_t(64), size_t(4096), size_t(64) }) {
+        (void)frame.allocate(3, 1);
+        void* ptr = frame.allocate(16, alignment);
+        CHECK(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+    }
+    CHECK(frame.currentFrameStats().overflowBytes == 0);
+
+    // Overflow blocks come from upstream with the requested alignment too
+    void* big = frame.allocate(128 * 1024, 4096);
+    CHECK(reinterpret_cast<uintptr_t>(big) % 4096 == 0);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include "Check.h"
+#include "HeapProfiler.h"
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+int main()
+{
+    // Drive the hooks directly with fake pointers, no operator new override needed
+    constexpr size_t interval = 4096;
+    constexpr size_t count = 200'000;
+    constexpr size_t size = 64;
+    utl::HeapProfiler::start(interval);
+    for (size_t i = 0; i < count; ++i) {
+        utl::HeapProfiler::onAllocation(reinterpret_cast<void*>((i + 1) * 16), size);
+    }
+    utl::HeapProfiler::stop();
+
+    // Folded output is unsampled: small allocations add up to about what was really allocated
+    std::ostringstream folded;
+    utl::HeapProfiler::writeFolded(folded, false);
+    std::istringstream lines(folded.str());
+    double total = 0;
+    for (std::string line; std::getline(lines, line);) total += std::stod(line.substr(line.rfind(' ') + 1));
+    const double expected = static_cast<double>(count * size);
+    CHECK(std::abs(total - expected) < expected * 0.1);
+
+    for (size_t i = 0; i < count; ++i) utl::HeapProfiler::onFree(reinterpret_cast<void*>((i + 1) * 16));
+    std::ostringstream live;
+    utl::HeapProfiler::writeFolded(live, true);
+    CHECK(live.str().empty());
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "Check.h"
+#include "HeapTracker.h"
+#include <thread>
+
+namespace {
+    // Constructed before the thread's first record, so destroyed after the exit flush
+    struct LateUser {
+        bool armed = false;
+        ~LateUser() {
+            if (!armed) return;
+            utl::HeapTracker::recordAllocation(100);
+            utl::HeapTracker::recordFree(100);
+        }
+    };
+    thread_local LateUser t_late;
+}
+
+int main()
+{
+    using utl::HeapTracker;
+    if (HeapTracker::isEnabled()) return 0; // the overrides would add the test's own allocations
+
+    // Counters a thread still holds when it exits are folded in
+    const HeapTracker::Snapshot before = HeapTracker::snapshot();
+    std::thread worker([] {
+        for (int i = 0; i < 10; ++i) HeapTracker::recordAllocation(32);
+        HeapTracker::recordFree(32);
+        });
+    worker.join();
+    HeapTracker::Snapshot after = HeapTracker::snapshot();
+    CHECK(after.allocations - before.allocations == 10 && after.frees - before.frees == 1);
+    CHECK(after.allocatedBytes - before.allocatedBytes == 320 && after.liveBytes() - before.liveBytes() == 288);
+
+    // Records from thread_local destructors that run after the exit flush go straight to the totals
+    std::thread late([] {
+        t_late.armed = true;
+        HeapTracker::recordAllocation(8);
+        });
+    late.join();
+    const HeapTracker::Snapshot last = HeapTracker::snapshot();
+    CHECK(last.allocations - after.allocations == 2 && last.frees - after.frees == 1);
+    CHECK(last.allocatedBytes - after.allocatedBytes == 108 && last.freedBytes - after.freedBytes == 100);
+
+    // Scoped records are attributed to their tag
+    {
+        HeapTracker::Scope scope(utl::StringHash("test"));
+        HeapTracker::recordAllocation(64);
+    }
+    std::array<HeapTracker::TagStats, HeapTracker::maxTags> tags;
+    const size_t count = HeapTracker::tagStats(tags);
+    bool found = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (tags[i].name == "test") found = tags[i].allocatedBytes == 64 && tags[i].allocations == 1;
+    }
+    CHECK(found);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "Check.h"
+#include "JaggedArray.h"
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+int main()
+{
+    utl::JaggedArray<int> array;
+    array.add({ 1, 2 });
+
+    const std::vector<size_t> sizes{ 1, 0, 3 };
+    const std::vector<int> values{ 3, 4, 5, 6 };
+    array.append(sizes, values);
+    CHECK(array.sliceCount() == 4);
+    CHECK(array[1].size() == 1 && array[1][0] == 3);
+    CHECK(array[2].empty());
+    CHECK(array[3].size() == 3 && array[3][2] == 6);
+
+    // Sizes that do not cover values exactly are rejected and leave the array alone
+    for (const std::vector<int>& mismatched : { std::vector<int>{ 3, 4, 5 }, std::vector<int>{ 3, 4, 5, 6, 7 } }) {
+        bool threw = false;
+        try {
+            array.append(sizes, mismatched);
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(array.sliceCount() == 4 && array.size() == 6);
+    }
+
+    // Sources inside the array itself stay valid while it grows
+    array.shrinkToFit();
+    CHECK(array.add(array[0]) == 4);
+    CHECK(array[4].size() == 2 && array[4][0] == 1 && array[4][1] == 2);
+    array.shrinkToFit();
+    CHECK(array.emplace(array[3][0], array[3][2]) == 5);
+    CHECK(array[5][0] == 4 && array[5][1] == 6);
+
+    array.shrinkToFit();
+    array.append(std::span<const size_t>(sizes), std::span<const int>(array.elements()).subspan(2, 4));
+    CHECK(array.sliceCount() == 9);
+    CHECK(array[6][0] == 3 && array[8][2] == 6);
+
+    // Appending an array to itself doubles it
+    const size_t slices = array.sliceCount();
+    const size_t elements = array.size();
+    array.shrinkToFit();
+    array.append(array);
+    CHECK(array.sliceCount() == slices * 2 && array.size() == elements * 2);
+    for (size_t i = 0; i < slices; ++i) {
+        CHECK(std::ranges::equal(array[i], array[slices + i]));
+    }
+
+    utl::JaggedSoA<int, float> soa;
+    const std::vector<int> ints{ 1, 2, 3 };
+    const std::vector<float> floats{ 0.5f, 1.5f, 2.5f };
+    soa.add(std::span<const int>(ints), std::span<const float>(floats));
+    soa.add(std::span<const int>(soa.slice<0>(0)), std::span<const float>(soa.slice<1>(0)));
+    CHECK(soa.sliceCount() == 2 && soa.slice<0>(1)[2] == 3 && soa.slice<1>(1)[0] == 0.5f);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "BinaryLog.h"
+#include "Check.h"
+#include "Debug.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    // setBinaryLog takes effect at the start of a pass, two flushed passes make sure one has started since
+    void settle()
+    {
+        for (int i = 0; i < 2; ++i) {
+            Debug::Info("settle {}", i);
+            Debug::Logger::Instance().flush();
+        }
+    }
+}
+
+int main()
+{
+    Debug::Init();
+    Debug::Logger& logger = Debug::Logger::Instance();
+    logger.clearSinks();
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "myutils-channel-test.bin";
+    logger.setBinaryLog(path);
+    settle();
+
+    // A channel with its own sink keeps getting text while the binary log is on
+    Debug::LogChannel& net = Debug::Channel("net");
+    const auto ring = std::make_shared<Debug::RingLogSink>(64 * 1024);
+    net.addSink(ring);
+    Debug::Info(net, "connected {}", 42);
+    Debug::Info(Debug::Channel("audio"), "device {}", 7);
+    Debug::Info("plain {}", 1);
+    logger.flush();
+
+    const std::string text = ring->contents();
+    CHECK(text.find("[net] connected 42") != std::string::npos);
+    CHECK(text.find("device 7") == std::string::npos);
+    CHECK(text.find("plain 1") == std::string::npos);
+
+    logger.setBinaryLog({});
+    settle();
+    net.clearSinks();
+
+    // Every message is in the binary log, tagged with its channel
+    std::ifstream in(path, std::ios::binary);
+    CHECK(in);
+    Debug::BinaryLogReader reader(in);
+    std::vector<char> out;
+    std::vector<std::string> channels;
+    for (size_t start = 0; reader.next(out); start = out.size()) {
+        const std::string_view message(out.data() + start, out.size() - start);
+        if (message.find("connected 42") != std::string_view::npos || message.find("device 7") != std::string_view::npos
+            || message.find("plain 1") != std::string_view::npos) {
+            channels.emplace_back(reader.channel());
+        }
+    }
+    const std::string_view decoded(out.data(), out.size());
+    CHECK(decoded.find("[net] connected 42") != std::string_view::npos);
+    CHECK(decoded.find("[audio] device 7") != std::string_view::npos);
+    CHECK((channels == std::vector<std::string>{ "net", "audio", "" }));
+
+    in.close();
+    std::filesystem::remove(path);
+    return 0;
+}
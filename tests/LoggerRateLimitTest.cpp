@@ -0,0 +1,45 @@
+#include "Check.h"
+#include "Debug.h"
+#include <memory>
+#include <string>
+
+namespace {
+    size_t count(const std::string& text, const std::string& needle)
+    {
+        size_t found = 0;
+        for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) ++found;
+        return found;
+    }
+}
+
+int main()
+{
+    Debug::Init();
+    Debug::Logger& logger = Debug::Logger::Instance();
+    logger.clearSinks();
+    const auto ring = std::make_shared<Debug::RingLogSink>(1 << 20);
+    logger.addSink(ring);
+
+    // Off by default: a busy call site gets every message through
+    CHECK(logger.getRateLimit().burst == 0);
+    for (int i = 0; i < 1000; ++i) Debug::Info("busy {}", i);
+    logger.flush();
+    CHECK(count(ring->contents(), "busy ") == 1000);
+    CHECK(logger.suppressedCount() == 0);
+
+    // Once enabled the burst passes and the rest is counted, severe types are never limited
+    ring->clear();
+    logger.setRateLimit({ 10, 1 });
+    for (int i = 0; i < 100; ++i) {
+        Debug::Warning("limited {}", i);
+        Debug::Error("error {}", i);
+        Debug::Exception("exception {}", i);
+    }
+    logger.flush();
+    const std::string text = ring->contents();
+    CHECK(count(text, "limited ") < 20);
+    CHECK(count(text, "error ") == 100);
+    CHECK(count(text, "exception ") == 100);
+    CHECK(logger.suppressedCount() > 80);
+    return 0;
+}
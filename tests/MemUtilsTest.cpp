@@ -0,0 +1,99 @@
+#include "Check.h"
+#include "MemUtils.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace {
+    bool aligned(const void* ptr, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+    }
+
+    bool allZero(const std::byte* data, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i) {
+            if (data[i] != std::byte{ 0 }) return false;
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    // The inverse factors are fractions, not integers that truncated to zero
+    static_assert(std::is_same_v<decltype(KB_TO_B), const double>);
+    static_assert(KB_TO_B * B_TO_KB == 1.0 && MB_TO_B * B_TO_MB == 1.0 && GB_TO_B * B_TO_GB == 1.0);
+    static_assert(1536 * KB_TO_B == 1.5 && MbToBytes(3) * MB_TO_B == 3.0 && GbToBytes(2) * GB_TO_B == 2.0);
+    static_assert(KbToBytes(4) == 4096 && BytesToMb(MbToBytes(7) + 1) == 7);
+
+    const size_t page = utl::PageSize();
+    const size_t hugePage = utl::HugePageSize();
+    CHECK(page >= 4096 && (page & (page - 1)) == 0);
+    CHECK(hugePage == 0 || (hugePage > page && (hugePage & (hugePage - 1)) == 0));
+    CHECK(utl::HugePageSize() == hugePage);
+
+    // Aligned heap allocations, including sizes of zero and alignments below a pointer
+    for (size_t alignment : { size_t(1), size_t(8), size_t(64), size_t(256), page }) {
+        for (size_t bytes : { size_t(0), size_t(1), size_t(100), size_t(10'000) }) {
+            void* ptr = utl::AlignedAlloc(bytes, alignment);
+            CHECK(ptr && aligned(ptr, std::max(alignment, sizeof(void*))));
+            std::memset(ptr, 0xCD, bytes);
+            utl::AlignedFree(ptr);
+        }
+    }
+    void* line = utl::CacheAlignedAlloc(10);
+    CHECK(aligned(line, utl::cacheLineSize));
+    utl::AlignedFree(line);
+    void* pageAligned = utl::PageAlignedAlloc(10);
+    CHECK(aligned(pageAligned, page));
+    utl::AlignedFree(pageAligned);
+    bool threw = false;
+    try {
+        utl::AlignedFree(utl::AlignedAlloc(SIZE_MAX / 2, 64));
+    }
+    catch (const std::bad_alloc&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // Mapped regions are page rounded, zero filled and huge page aligned when asked
+    CHECK(utl::MapRegionSize(0) == page && utl::MapRegionSize(page + 1) == 2 * page);
+    for (utl::MapFlags flags : { utl::MapFlags{}, utl::MapFlags(utl::MapFlagBits::populate), utl::MapFlags(utl::MapFlagBits::hugePages) }) {
+        const size_t bytes = 3 * page + 5;
+        const size_t mapped = utl::MapRegionSize(bytes, flags);
+        CHECK(mapped >= bytes && mapped % page == 0);
+        auto* region = static_cast<std::byte*>(utl::MapRegion(bytes, flags));
+        CHECK(region && aligned(region, page) && allZero(region, mapped));
+        if (flags.has(utl::MapFlagBits::hugePages) && hugePage != 0) {
+            CHECK(mapped % hugePage == 0 && aligned(region, hugePage));
+        }
+        std::memset(region, 0x5A, mapped);
+        utl::UnmapRegion(region, bytes, flags);
+    }
+
+    // HugeBuffer owns its mapping, moves it and can drop the physical pages
+    {
+        utl::HugeBuffer buffer(3 * 1024 * 1024 + 1);
+        CHECK(buffer && buffer.size() == 3 * 1024 * 1024 + 1);
+        CHECK(buffer.mappedSize() == utl::MapRegionSize(buffer.size(), utl::MapFlagBits::hugePages));
+        CHECK(hugePage == 0 || aligned(buffer.data(), hugePage));
+        auto words = buffer.as<uint64_t>();
+        CHECK(words.size() == buffer.size() / sizeof(uint64_t));
+        for (size_t i = 0; i < words.size(); ++i) words[i] = i + 1;
+
+        utl::HugeBuffer moved(std::move(buffer));
+        CHECK(!buffer && buffer.size() == 0 && moved.as<uint64_t>()[words.size() - 1] == words.size());
+        moved.discard();
+        CHECK(moved && allZero(moved.data(), moved.size()));
+
+        buffer = utl::HugeBuffer(100, utl::MapFlags{});
+        CHECK(buffer.mappedSize() == page && allZero(buffer.data(), page));
+        buffer.reset();
+        CHECK(!buffer && buffer.data() == nullptr && buffer.mappedSize() == 0);
+    }
+    return 0;
+}
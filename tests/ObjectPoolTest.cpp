@@ -0,0 +1,45 @@
+#include "Check.h"
+#include "ObjectPool.h"
+#include <stdexcept>
+#include <string>
+
+namespace {
+    struct ThrowingReset {
+        bool* fail;
+        void operator()(std::string& text) const {
+            if (*fail) throw std::runtime_error("reset failed");
+            text.clear();
+        }
+    };
+}
+
+int main()
+{
+    bool fail = false;
+    utl::ObjectPool<std::string, ThrowingReset> pool(4, ThrowingReset{ &fail });
+
+    {
+        auto handle = pool.rent();
+        *handle = "kept";
+    }
+    CHECK(pool.idleCount() == 1);
+    CHECK(pool.rent()->empty());
+
+    // A throwing reset discards the object instead of escaping the destructor
+    fail = true;
+    {
+        auto handle = pool.rent();
+        *handle = "dropped";
+    }
+    CHECK(pool.idleCount() == 0);
+
+    auto handle = pool.rent();
+    handle.reset();
+    CHECK(!handle && pool.idleCount() == 0);
+
+    fail = false;
+    handle = pool.rent();
+    handle = pool.rent();
+    CHECK(pool.idleCount() == 1);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "Check.h"
+#include "SlabAllocator.h"
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+namespace {
+    bool aligned(const void* ptr, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+    }
+
+    // Constructed before the thread's first slab call, so destroyed after the cache was flushed
+    struct LateUser {
+        bool armed = false;
+        ~LateUser() {
+            if (!armed) return;
+            void* ptr = utl::SlabAllocator::allocate(48);
+            std::memset(ptr, 0, 48);
+            utl::SlabAllocator::deallocate(ptr, 48);
+        }
+    };
+    thread_local LateUser t_late;
+}
+
+int main()
+{
+    using utl::SlabAllocator;
+
+    // Every size maps to the smallest class that holds it, and classes map back to themselves
+    for (size_t index = 0; index < SlabAllocator::classCount; ++index) {
+        CHECK(SlabAllocator::sizeClass(SlabAllocator::classSize(index)) == index);
+        if (index > 0) CHECK(SlabAllocator::classSize(index - 1) < SlabAllocator::classSize(index));
+    }
+    for (size_t bytes = 1; bytes <= SlabAllocator::maxSmallSize; ++bytes) {
+        const size_t index = SlabAllocator::sizeClass(bytes);
+        CHECK(index < SlabAllocator::classCount);
+        CHECK(SlabAllocator::classSize(index) >= bytes);
+        CHECK(index == 0 || SlabAllocator::classSize(index - 1) < bytes);
+    }
+    CHECK(SlabAllocator::sizeClass(SlabAllocator::maxSmallSize + 1) == SlabAllocator::classCount);
+
+    // Small objects are max_align_t aligned, large and over-aligned ones bypass the slabs
+    for (size_t bytes : { 1, 8, 24, 100, 129, 1000, 1024 }) {
+        void* ptr = SlabAllocator::allocate(bytes);
+        CHECK(aligned(ptr, bytes < 16 ? 8 : alignof(std::max_align_t)));
+        std::memset(ptr, 0xAB, bytes);
+        SlabAllocator::deallocate(ptr, bytes);
+    }
+    const size_t largeBefore = SlabAllocator::stats().largeAllocations;
+    void* large = SlabAllocator::allocate(4096);
+    void* overAligned = SlabAllocator::allocate(64, 256);
+    CHECK(aligned(overAligned, 256));
+    CHECK(SlabAllocator::stats().largeAllocations == largeBefore + 2);
+    SlabAllocator::deallocate(large, 4096);
+    SlabAllocator::deallocate(overAligned, 64, 256);
+
+    // Freed memory is reused instead of carving new slabs
+    {
+        std::vector<void*> objects;
+        for (int i = 0; i < 1000; ++i) objects.push_back(SlabAllocator::allocate(64));
+        for (void* ptr : objects) SlabAllocator::deallocate(ptr, 64);
+        const size_t slabBytes = SlabAllocator::stats().slabBytes;
+        for (int round = 0; round < 10; ++round) {
+            for (auto& ptr : objects) ptr = SlabAllocator::allocate(64);
+            for (void* ptr : objects) SlabAllocator::deallocate(ptr, 64);
+        }
+        CHECK(SlabAllocator::stats().slabBytes == slabBytes);
+    }
+
+    // Objects freed on another thread, and everything a thread cached when it exits, come back
+    {
+        constexpr size_t count = 20'000;
+        std::vector<void*> objects(count);
+        for (int round = 0; round < 5; ++round) {
+            std::thread producer([&] {
+                for (auto& ptr : objects) {
+                    ptr = SlabAllocator::allocate(200);
+                    std::memset(ptr, round, 200);
+                }
+                });
+            producer.join();
+            std::thread consumer([&] {
+                for (void* ptr : objects) SlabAllocator::deallocate(ptr, 200);
+                });
+            consumer.join();
+        }
+        // Five rounds of 20000 objects stay within the slabs of about one round
+        const size_t perRound = count * SlabAllocator::classSize(SlabAllocator::sizeClass(200));
+        CHECK(SlabAllocator::stats().slabBytes < 3 * perRound);
+    }
+
+    // Thread-local destructors that run after the exit flush still work
+    std::thread late([] {
+        t_late.armed = true;
+        SlabAllocator::deallocate(SlabAllocator::allocate(48), 48);
+        });
+    late.join();
+
+    // memory_resource and STL allocator paths
+    {
+        std::pmr::vector<int> values(SlabAllocator::resource());
+        for (int i = 0; i < 300; ++i) values.push_back(i);
+        CHECK(values[299] == 299);
+        CHECK(SlabAllocator::resource()->is_equal(utl::SlabResource()));
+
+        std::list<int, utl::StlSlabAllocator<int>> list;
+        for (int i = 0; i < 1000; ++i) list.push_back(i);
+        list.remove_if([](int value) { return value % 2 == 0; });
+        CHECK(list.size() == 500 && list.front() == 1 && list.back() == 999);
+
+        std::vector<double, utl::StlSlabAllocator<double>> doubles(200, 1.5);
+        CHECK(doubles.back() == 1.5);
+    }
+    return 0;
+}
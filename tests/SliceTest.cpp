@@ -0,0 +1,34 @@
+#include "Check.h"
+#include "Slice.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+int main()
+{
+    static_assert(std::random_access_iterator<utl::StridedSlice<int>::Iterator>);
+
+    // Every third element of 10: the last one is at 9, end() must not form data + 12
+    std::array<int, 10> values{};
+    std::iota(values.begin(), values.end(), 0);
+    const utl::StridedSlice<int> view(values.data(), 4, 3);
+
+    const std::vector<int> forward(view.begin(), view.end());
+    CHECK((forward == std::vector<int>{ 0, 3, 6, 9 }));
+    const std::vector<int> backward(std::make_reverse_iterator(view.end()), std::make_reverse_iterator(view.begin()));
+    CHECK((backward == std::vector<int>{ 9, 6, 3, 0 }));
+    CHECK(view.end() - view.begin() == 4);
+    CHECK(view.begin()[3] == 9 && *(view.end() - 1) == 9);
+    CHECK(std::ranges::find(view, 6) - view.begin() == 2);
+
+    const auto tail = view.subslice(4);
+    CHECK(tail.isEmpty() && tail.begin() == tail.end());
+    const auto every = view.strided(2, 1);
+    CHECK(every.getSize() == 2 && every[0] == 3 && every[1] == 9);
+
+    std::ranges::fill(view, -1);
+    CHECK(values[9] == -1 && values[8] == 8);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "Check.h"
+#include "SmallVector.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+    // Counts live objects; copies throw once failAfter more have been made
+    struct Fragile {
+        static inline int live = 0;
+        static inline int failAfter = -1;
+
+        int value;
+
+        explicit Fragile(int v) : value(v) { ++live; }
+        Fragile(const Fragile& other) : value(other.value) {
+            if (failAfter == 0) throw std::runtime_error("copy failed");
+            if (failAfter > 0) --failAfter;
+            ++live;
+        }
+        // May throw, so growth has to copy
+        Fragile(Fragile&& other) noexcept(false) : value(std::exchange(other.value, -1)) { ++live; }
+        Fragile& operator=(const Fragile&) = default;
+        Fragile& operator=(Fragile&&) = default;
+        ~Fragile() { --live; }
+    };
+}
+
+int main()
+{
+    // Spilling from inline storage to the heap and back
+    {
+        utl::SmallVector<std::string, 4> strings;
+        for (int i = 0; i < 4; ++i) strings.push_back(std::string(32, static_cast<char>('a' + i)));
+        CHECK(strings.isInline());
+        strings.push_back("spilled");
+        CHECK(!strings.isInline() && strings.size() == 5);
+        CHECK(strings[0] == std::string(32, 'a') && strings[4] == "spilled");
+        strings.pop_back();
+        strings.shrinkToFit();
+        CHECK(strings.isInline() && strings[3] == std::string(32, 'd'));
+    }
+
+    // Arguments that refer to an element survive the growth they cause
+    {
+        utl::SmallVector<std::string, 2> strings{ "first", "second" };
+        strings.push_back(strings[0]);
+        CHECK(strings.size() == 3 && strings[2] == "first");
+        strings.emplace_back(strings[1]);
+        strings.insert(strings.begin(), strings.back());
+        CHECK(strings.size() == 5 && strings[0] == "second" && strings[1] == "first");
+
+        utl::SmallVector<int, 2> ints{ 1, 2 };
+        ints.insert(ints.begin() + 1, ints[1]);
+        ints.insert(ints.begin(), ints[2]);
+        CHECK((ints == utl::SmallVector<int, 2>{ 2, 1, 2, 2 }));
+        ints.resize(10, ints[0]);
+        CHECK(ints.size() == 10 && ints[9] == 2);
+    }
+
+    // Copies and moves between inline and heap states
+    {
+        utl::SmallVector<std::unique_ptr<int>, 2> small;
+        small.push_back(std::make_unique<int>(1));
+        utl::SmallVector<std::unique_ptr<int>, 2> large;
+        for (int i = 0; i < 3; ++i) large.push_back(std::make_unique<int>(10 + i));
+
+        utl::SmallVector<std::unique_ptr<int>, 2> movedInline(std::move(small));
+        CHECK(movedInline.isInline() && *movedInline[0] == 1 && small.empty());
+        const int* heapData = large.data()->get();
+        utl::SmallVector<std::unique_ptr<int>, 2> movedHeap(std::move(large));
+        CHECK(!movedHeap.isInline() && movedHeap[0].get() == heapData && large.empty() && large.isInline());
+
+        movedHeap = std::move(movedInline);
+        CHECK(movedHeap.isInline() && movedHeap.size() == 1 && *movedHeap[0] == 1);
+
+        utl::SmallVector<std::string, 2> strings{ "a", "b", "c" };
+        utl::SmallVector<std::string, 2> copy(strings);
+        CHECK(copy == strings && !copy.isInline());
+        copy = utl::SmallVector<std::string, 2>{ "x" };
+        CHECK(copy.size() == 1 && copy[0] == "x");
+        copy = strings;
+        CHECK(copy == strings);
+        strings = std::move(copy);
+        CHECK(strings.size() == 3 && strings[2] == "c");
+    }
+
+    // A copy failing during growth leaves the vector as it was and leaks nothing
+    {
+        utl::SmallVector<Fragile, 4> values;
+        for (int i = 0; i < 4; ++i) values.emplace_back(i);
+        Fragile::failAfter = 2;
+        bool threw = false;
+        try {
+            values.emplace_back(4);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        Fragile::failAfter = -1;
+        CHECK(threw);
+        CHECK(values.isInline() && values.size() == 4);
+        for (int i = 0; i < 4; ++i) CHECK(values[i].value == i);
+        CHECK(Fragile::live == 4);
+
+        values.emplace_back(4);
+        Fragile::failAfter = 1;
+        threw = false;
+        try {
+            values.reserve(64);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        Fragile::failAfter = -1;
+        CHECK(threw && values.size() == 5 && values[4].value == 4 && values.capacity() < 64);
+        CHECK(Fragile::live == 5);
+    }
+    CHECK(Fragile::live == 0);
+    return 0;
+}
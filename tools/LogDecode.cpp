@@ -0,0 +1,57 @@
+// myutils-logdecode: turn a binary log written by Debug::Logger::setBinaryLog back into text
+//   myutils-logdecode [--channel name] <log.bin> [output.txt]
+// --channel keeps only the messages of one channel
+#include "BinaryLog.h"
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    std::optional<std::string_view> channel;
+    if (argc >= 3 && std::string_view(argv[1]) == "--channel") {
+        channel = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: myutils-logdecode [--channel name] <log.bin> [output.txt]\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << "\n";
+        return 1;
+    }
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2], std::ios::out | std::ios::trunc);
+        if (!file) {
+            std::cerr << "cannot open " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = argc == 3 ? static_cast<std::ostream&>(file) : std::cout;
+
+    try {
+        Debug::BinaryLogReader reader(in);
+        std::vector<char> buffer;
+        buffer.reserve(64 * 1024);
+        for (size_t start = 0; reader.next(buffer); start = buffer.size()) {
+            if (channel && reader.channel() != *channel) buffer.resize(start);
+            if (buffer.size() >= 60 * 1024) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    catch (const std::exception& e) {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}